@@ -0,0 +1,162 @@
+#ifndef _FDT_LATENCY_HISTOGRAM_H_
+#define _FDT_LATENCY_HISTOGRAM_H_
+
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+#include <algorithm>
+#include <ostream>
+
+namespace fdt {
+// Log-linear histogram in the style of HdrHistogram: every power of two is
+// split into 2^SubBucketBits linear sub-buckets, so recorded values keep a
+// relative precision of about 2^-SubBucketBits over the full 64-bit range.
+template <unsigned SubBucketBits = 7>
+class LatencyHistogram {
+public:
+  LatencyHistogram();
+
+  void record(uint64_t value);
+  void merge(const LatencyHistogram& other);
+  void reset();
+
+  uint64_t count() const;
+  uint64_t min() const;
+  uint64_t max() const;
+  double mean() const;
+  uint64_t percentile(double percent) const;
+
+  void print(std::ostream& out, const char* unit) const;
+
+private:
+  static const uint64_t SUB_BUCKETS = uint64_t(1) << SubBucketBits;
+  static const size_t BUCKETS = (65 - SubBucketBits) * SUB_BUCKETS;
+
+  std::vector<uint64_t> counts_;
+  uint64_t count_;
+  uint64_t min_;
+  uint64_t max_;
+  double sum_;
+
+  static size_t index_of(uint64_t value);
+  static uint64_t highest_equivalent(size_t index);
+};
+
+template <unsigned SubBucketBits>
+LatencyHistogram<SubBucketBits>::LatencyHistogram() : counts_(BUCKETS) {
+  reset();
+}
+
+template <unsigned SubBucketBits>
+void LatencyHistogram<SubBucketBits>::record(uint64_t value) {
+  counts_[index_of(value)]++;
+  count_++;
+  sum_ += value;
+  if (value < min_) {
+    min_ = value;
+  }
+  if (value > max_) {
+    max_ = value;
+  }
+}
+
+template <unsigned SubBucketBits>
+void LatencyHistogram<SubBucketBits>::merge(const LatencyHistogram& other) {
+  for (size_t i = 0; i < BUCKETS; i++) {
+    counts_[i] += other.counts_[i];
+  }
+  count_ += other.count_;
+  sum_ += other.sum_;
+  if (other.min_ < min_) {
+    min_ = other.min_;
+  }
+  if (other.max_ > max_) {
+    max_ = other.max_;
+  }
+}
+
+template <unsigned SubBucketBits>
+void LatencyHistogram<SubBucketBits>::reset() {
+  std::fill(counts_.begin(), counts_.end(), 0);
+  count_ = 0;
+  min_ = UINT64_MAX;
+  max_ = 0;
+  sum_ = 0;
+}
+
+template <unsigned SubBucketBits>
+uint64_t LatencyHistogram<SubBucketBits>::count() const {
+  return count_;
+}
+
+template <unsigned SubBucketBits>
+uint64_t LatencyHistogram<SubBucketBits>::min() const {
+  return count_ == 0 ? 0 : min_;
+}
+
+template <unsigned SubBucketBits>
+uint64_t LatencyHistogram<SubBucketBits>::max() const {
+  return max_;
+}
+
+template <unsigned SubBucketBits>
+double LatencyHistogram<SubBucketBits>::mean() const {
+  return count_ == 0 ? 0 : sum_ / count_;
+}
+
+template <unsigned SubBucketBits>
+uint64_t LatencyHistogram<SubBucketBits>::percentile(double percent) const {
+  if (count_ == 0) {
+    return 0;
+  }
+  uint64_t target = (uint64_t) (percent / 100.0 * count_ + 0.5);
+  if (target == 0) {
+    target = 1;
+  }
+  uint64_t seen = 0;
+  for (size_t i = 0; i < BUCKETS; i++) {
+    seen += counts_[i];
+    if (seen >= target) {
+      uint64_t value = highest_equivalent(i);
+      return value < max_ ? value : max_;
+    }
+  }
+  return max_;
+}
+
+template <unsigned SubBucketBits>
+void LatencyHistogram<SubBucketBits>::print(std::ostream& out, const char* unit) const {
+  out << "count " << count_ << "\n"
+      << "min   " << min() << " " << unit << "\n"
+      << "mean  " << (uint64_t) mean() << " " << unit << "\n"
+      << "p50   " << percentile(50) << " " << unit << "\n"
+      << "p90   " << percentile(90) << " " << unit << "\n"
+      << "p99   " << percentile(99) << " " << unit << "\n"
+      << "p99.9 " << percentile(99.9) << " " << unit << "\n"
+      << "p99.99 " << percentile(99.99) << " " << unit << "\n"
+      << "max   " << max() << " " << unit << "\n";
+}
+
+template <unsigned SubBucketBits>
+size_t LatencyHistogram<SubBucketBits>::index_of(uint64_t value) {
+  if (value < SUB_BUCKETS) {
+    return (size_t) value;
+  }
+  unsigned msb = 63 - __builtin_clzll(value);
+  unsigned exponent = msb - SubBucketBits + 1;
+  uint64_t mantissa = value >> (exponent - 1);
+  return exponent * SUB_BUCKETS + (size_t) (mantissa - SUB_BUCKETS);
+}
+
+template <unsigned SubBucketBits>
+uint64_t LatencyHistogram<SubBucketBits>::highest_equivalent(size_t index) {
+  uint64_t exponent = index / SUB_BUCKETS;
+  uint64_t mantissa = index % SUB_BUCKETS;
+  if (exponent == 0) {
+    return mantissa;
+  }
+  uint64_t lowest = (mantissa + SUB_BUCKETS) << (exponent - 1);
+  return lowest + ((uint64_t(1) << (exponent - 1)) - 1);
+}
+}
+#endif
@@ -0,0 +1,78 @@
+#ifndef _FDT_MIXED_ENDS_H_
+#define _FDT_MIXED_ENDS_H_
+
+#include <Deque.h>
+
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace fdt {
+// Deque behind one std::mutex, the baseline for the concurrent deques.
+class MutexDeque {
+public:
+  void push_front(int value) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    deque_.push_front(value);
+  }
+
+  void push_back(int value) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    deque_.push_back(value);
+  }
+
+  bool try_pop_front(int& value) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (deque_.empty()) {
+      return false;
+    }
+    value = deque_.front();
+    deque_.pop_front();
+    return true;
+  }
+
+  bool try_pop_back(int& value) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (deque_.empty()) {
+      return false;
+    }
+    value = deque_.back();
+    deque_.pop_back();
+    return true;
+  }
+
+private:
+  std::mutex mutex_;
+  Deque<int> deque_;
+};
+
+// Thread `thread` alternates between the two ends, pushing and then popping,
+// so both ends stay busy and the deque stays small enough that many
+// operations meet the other end.
+template <class Queue>
+void mixed_ends(Queue& q, int thread, int ops) {
+  int value;
+  for (int i = 0; i < ops; i++) {
+    if ((thread + i) % 2 == 0) {
+      q.push_back(i);
+      q.try_pop_front(value);
+    } else {
+      q.push_front(i);
+      q.try_pop_back(value);
+    }
+  }
+}
+
+// Runs run(t) on threads 0 to threads - 1 and waits for all of them.
+template <class Run>
+void run_threads(int threads, Run run) {
+  std::vector<std::thread> workers;
+  for (int t = 0; t < threads; t++) {
+    workers.emplace_back(run, t);
+  }
+  for (std::thread& worker : workers) {
+    worker.join();
+  }
+}
+}
+#endif
@@ -0,0 +1,98 @@
+#include <benchmark/benchmark.h>
+#include <Deque.h>
+#include <HugePageAllocator.h>
+#include <cstdint>
+#include <memory>
+
+// Random-access and streaming reads over a Deque whose storage comes from
+// std::allocator or from HugePageAllocator with 4 KiB, transparent huge or
+// explicit huge pages. The large size is well past what the TLB covers with
+// 4 KiB pages, which is where huge pages are expected to pay off.
+static fdt::HugePageAllocator<uint64_t> huge_page_allocator(fdt::HugePages pages) {
+  fdt::HugePageOptions options;
+  options.huge_pages = pages;
+  options.prefault = true;
+  return fdt::HugePageAllocator<uint64_t>(options);
+}
+
+template <class Allocator>
+static void fill(fdt::Deque<uint64_t, Allocator>& q, size_t count) {
+  for (size_t i = 0; i < count; i++) {
+    q.push_back(i);
+  }
+}
+
+template <class Allocator>
+static void random_access(benchmark::State& state, const Allocator& alloca) {
+  const size_t count = state.range(0);
+  fdt::Deque<uint64_t, Allocator> q(count + 1, alloca);
+  fill(q, count);
+  uint64_t x = 88172645463325252ULL;
+  uint64_t sum = 0;
+  for (auto _ : state) {
+    for (int i = 0; i < 1024; i++) {
+      x ^= x << 13;
+      x ^= x >> 7;
+      x ^= x << 17;
+      sum += q[x % count];
+    }
+  }
+  benchmark::DoNotOptimize(sum);
+  state.SetItemsProcessed(state.iterations() * 1024);
+}
+
+template <class Allocator>
+static void streaming(benchmark::State& state, const Allocator& alloca) {
+  const size_t count = state.range(0);
+  fdt::Deque<uint64_t, Allocator> q(count + 1, alloca);
+  fill(q, count);
+  for (auto _ : state) {
+    uint64_t sum = 0;
+    for (size_t i = 0; i < count; i++) {
+      sum += q[i];
+    }
+    benchmark::DoNotOptimize(sum);
+  }
+  state.SetBytesProcessed(state.iterations() * count * sizeof(uint64_t));
+}
+
+static void BM_std_allocator_random_access(benchmark::State& state) {
+  random_access(state, std::allocator<uint64_t>());
+}
+
+static void BM_small_page_random_access(benchmark::State& state) {
+  random_access(state, huge_page_allocator(fdt::HugePages::None));
+}
+
+static void BM_transparent_huge_page_random_access(benchmark::State& state) {
+  random_access(state, huge_page_allocator(fdt::HugePages::Transparent));
+}
+
+static void BM_explicit_huge_page_random_access(benchmark::State& state) {
+  random_access(state, huge_page_allocator(fdt::HugePages::Explicit));
+}
+
+static void BM_std_allocator_streaming(benchmark::State& state) {
+  streaming(state, std::allocator<uint64_t>());
+}
+
+static void BM_small_page_streaming(benchmark::State& state) {
+  streaming(state, huge_page_allocator(fdt::HugePages::None));
+}
+
+static void BM_transparent_huge_page_streaming(benchmark::State& state) {
+  streaming(state, huge_page_allocator(fdt::HugePages::Transparent));
+}
+
+static void BM_explicit_huge_page_streaming(benchmark::State& state) {
+  streaming(state, huge_page_allocator(fdt::HugePages::Explicit));
+}
+
+BENCHMARK(BM_std_allocator_random_access)->Arg(1 << 16)->Arg(1 << 24);
+BENCHMARK(BM_small_page_random_access)->Arg(1 << 16)->Arg(1 << 24);
+BENCHMARK(BM_transparent_huge_page_random_access)->Arg(1 << 16)->Arg(1 << 24);
+BENCHMARK(BM_explicit_huge_page_random_access)->Arg(1 << 16)->Arg(1 << 24);
+BENCHMARK(BM_std_allocator_streaming)->Arg(1 << 16)->Arg(1 << 24);
+BENCHMARK(BM_small_page_streaming)->Arg(1 << 16)->Arg(1 << 24);
+BENCHMARK(BM_transparent_huge_page_streaming)->Arg(1 << 16)->Arg(1 << 24);
+BENCHMARK(BM_explicit_huge_page_streaming)->Arg(1 << 16)->Arg(1 << 24);
@@ -0,0 +1,82 @@
+#include <benchmark/benchmark.h>
+#include <ByteRing.h>
+#include <LockfreeQueue.h>
+#include <cstring>
+#include <string>
+#include <thread>
+
+const int MESSAGES = 100000;
+const size_t RING_BYTES = 1 << 20;
+
+// Message sizes between 40 bytes and 4KB from a fixed sequence, so both
+// queues carry the same traffic.
+static size_t message_size(unsigned& x) {
+  x = x * 1103515245 + 12345;
+  return 40 + (x >> 8) % (4096 - 40 + 1);
+}
+
+// Producer serializes into the ring and the consumer reads in place.
+static void BM_byte_ring_messages(benchmark::State& state) {
+  static char payload[4096];
+  for (auto _ : state) {
+    fdt::ByteRing ring(RING_BYTES);
+    std::thread producer([&ring] {
+      unsigned x = 1;
+      for (int i = 0; i < MESSAGES; i++) {
+        size_t size = message_size(x);
+        fdt::Span<char> span;
+        while (!ring.reserve_write(size, span)) {
+          std::this_thread::yield();
+        }
+        std::memcpy(span.data(), payload, size);
+        ring.commit_write();
+      }
+    });
+    size_t bytes = 0;
+    for (int i = 0; i < MESSAGES; i++) {
+      fdt::Span<const char> span;
+      while (!ring.peek_read(span)) {
+        std::this_thread::yield();
+      }
+      bytes += span.size() + span[0];
+      ring.release_read();
+    }
+    producer.join();
+    benchmark::DoNotOptimize(bytes);
+  }
+  state.SetItemsProcessed(state.iterations() * MESSAGES);
+}
+
+// The same traffic through a ring of pointers to heap-allocated messages.
+static void BM_queue_heap_messages(benchmark::State& state) {
+  static char payload[4096];
+  for (auto _ : state) {
+    fdt::LockfreeQueue<std::string*> q(RING_BYTES / 2048);
+    std::thread producer([&q] {
+      unsigned x = 1;
+      for (int i = 0; i < MESSAGES; i++) {
+        size_t size = message_size(x);
+        while (q.full()) {
+          std::this_thread::yield();
+        }
+        q.push_back(new std::string(payload, size));
+      }
+    });
+    size_t bytes = 0;
+    for (int i = 0; i < MESSAGES; i++) {
+      while (q.empty()) {
+        std::this_thread::yield();
+      }
+      std::string* message = q.front();
+      bytes += message->size() + (*message)[0];
+      delete message;
+      q.pop_front();
+    }
+    producer.join();
+    benchmark::DoNotOptimize(bytes);
+  }
+  state.SetItemsProcessed(state.iterations() * MESSAGES);
+}
+
+BENCHMARK(BM_byte_ring_messages)->UseRealTime();
+BENCHMARK(BM_queue_heap_messages)->UseRealTime();
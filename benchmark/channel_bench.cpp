@@ -0,0 +1,147 @@
+#include <benchmark/benchmark.h>
+#include <Channel.h>
+#include <LockfreeQueue.h>
+#include <coroutine>
+#include <deque>
+#include <exception>
+#include <memory>
+#include <thread>
+#include <vector>
+
+const int ITER_TIME = 30000;
+const size_t QUEUE_CAPACITY = 64;
+
+// Minimal example executor: a single-threaded run loop that owns spawned
+// coroutines and resumes whatever is ready. Channel wakeups resume the other
+// side inline, so the loop only starts tasks and runs explicit yields.
+class RunLoop {
+public:
+  struct Task {
+    struct promise_type {
+      Task get_return_object() {
+        return Task{std::coroutine_handle<promise_type>::from_promise(*this)};
+      }
+      std::suspend_always initial_suspend() noexcept { return {}; }
+      std::suspend_always final_suspend() noexcept { return {}; }
+      void return_void() {}
+      void unhandled_exception() { std::terminate(); }
+    };
+
+    std::coroutine_handle<promise_type> handle;
+  };
+
+  struct YieldAwaiter {
+    RunLoop* loop;
+    bool await_ready() { return false; }
+    void await_suspend(std::coroutine_handle<> handle) { loop->ready_.push_back(handle); }
+    void await_resume() {}
+  };
+
+  RunLoop() = default;
+  RunLoop(const RunLoop&) = delete;
+  RunLoop& operator=(const RunLoop&) = delete;
+
+  ~RunLoop() {
+    for (std::coroutine_handle<Task::promise_type> handle : tasks_) {
+      handle.destroy();
+    }
+  }
+
+  void spawn(Task task) {
+    tasks_.push_back(task.handle);
+    ready_.push_back(task.handle);
+  }
+
+  YieldAwaiter yield() {
+    return YieldAwaiter{this};
+  }
+
+  void run() {
+    while (!ready_.empty()) {
+      std::coroutine_handle<> handle = ready_.front();
+      ready_.pop_front();
+      handle.resume();
+    }
+  }
+
+private:
+  std::deque<std::coroutine_handle<>> ready_;
+  std::vector<std::coroutine_handle<Task::promise_type>> tasks_;
+};
+
+static RunLoop::Task produce(fdt::Channel<int>& channel) {
+  for (int i = 0; i < ITER_TIME; i++) {
+    co_await channel.push(i);
+  }
+}
+
+static RunLoop::Task consume(fdt::Channel<int>& channel, long& sum) {
+  for (int i = 0; i < ITER_TIME; i++) {
+    sum += co_await channel.pop();
+  }
+}
+
+static void BM_channel_coroutine_per_queue(benchmark::State& state) {
+  size_t queues = state.range(0);
+  for (auto _ : state) {
+    state.PauseTiming();
+    std::vector<std::unique_ptr<fdt::Channel<int>>> channels;
+    std::vector<long> sums(queues, 0);
+    RunLoop loop;
+    for (size_t i = 0; i < queues; i++) {
+      channels.emplace_back(new fdt::Channel<int>(QUEUE_CAPACITY));
+      loop.spawn(consume(*channels[i], sums[i]));
+      loop.spawn(produce(*channels[i]));
+    }
+    state.ResumeTiming();
+    loop.run();
+    benchmark::DoNotOptimize(sums.data());
+  }
+  state.SetItemsProcessed(state.iterations() * queues * ITER_TIME);
+}
+
+static void BM_thread_per_queue(benchmark::State& state) {
+  size_t queues = state.range(0);
+  for (auto _ : state) {
+    state.PauseTiming();
+    std::vector<std::unique_ptr<fdt::LockfreeQueue<int>>> rings;
+    std::vector<long> sums(queues, 0);
+    for (size_t i = 0; i < queues; i++) {
+      rings.emplace_back(new fdt::LockfreeQueue<int>(QUEUE_CAPACITY));
+    }
+    state.ResumeTiming();
+    std::vector<std::thread> threads;
+    for (size_t i = 0; i < queues; i++) {
+      fdt::LockfreeQueue<int>& q = *rings[i];
+      long& sum = sums[i];
+      threads.emplace_back([&q] {
+        for (int i = 0; i < ITER_TIME; i++) {
+          while (q.full()) {
+            std::this_thread::yield();
+          }
+          q.push_back(i);
+        }
+      });
+      threads.emplace_back([&q, &sum] {
+        for (int i = 0; i < ITER_TIME; i++) {
+          while (q.empty()) {
+            std::this_thread::yield();
+          }
+          sum += q.front();
+          q.pop_front();
+        }
+      });
+    }
+    for (std::thread& thread : threads) {
+      thread.join();
+    }
+    benchmark::DoNotOptimize(sums.data());
+  }
+  state.SetItemsProcessed(state.iterations() * queues * ITER_TIME);
+}
+
+BENCHMARK(BM_channel_coroutine_per_queue)->Arg(1)->Arg(4)->Arg(16)->UseRealTime();
+BENCHMARK(BM_thread_per_queue)->Arg(1)->Arg(4)->Arg(16)->UseRealTime();
+
+
+BENCHMARK_MAIN();
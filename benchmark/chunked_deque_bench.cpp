@@ -0,0 +1,84 @@
+#include <benchmark/benchmark.h>
+#include <Deque.h>
+#include <ChunkedDeque.h>
+#include <chrono>
+#include <deque>
+
+// Grows each container from empty and reports, besides the total time, the
+// slowest single push_back: the reallocation spike of the contiguous Deque
+// against incremental growth and the bounded per-block cost of ChunkedDeque.
+template <typename Queue>
+static void push_back_growth(benchmark::State& state) {
+    const int count = state.range(0);
+    double worst_ns = 0;
+    for (auto _ : state) {
+        Queue q;
+        for (int i = 0; i < count; i++) {
+            std::chrono::steady_clock::time_point begin = std::chrono::steady_clock::now();
+            q.push_back(i);
+            double ns = std::chrono::duration<double, std::nano>(
+                    std::chrono::steady_clock::now() - begin).count();
+            if (ns > worst_ns) {
+                worst_ns = ns;
+            }
+        }
+        benchmark::DoNotOptimize(q.back());
+    }
+    state.counters["max_push_ns"] = worst_ns;
+    state.SetItemsProcessed(state.iterations() * count);
+}
+
+static void BM_queue_push_back_growth(benchmark::State& state) {
+    push_back_growth<fdt::Deque<int> >(state);
+}
+
+struct IncrementalDeque : fdt::Deque<int> {
+    IncrementalDeque() {
+        set_incremental_growth(4);
+    }
+};
+
+static void BM_incremental_queue_push_back_growth(benchmark::State& state) {
+    push_back_growth<IncrementalDeque>(state);
+}
+
+static void BM_chunked_queue_push_back_growth(benchmark::State& state) {
+    push_back_growth<fdt::ChunkedDeque<int> >(state);
+}
+
+static void BM_std_queue_push_back_growth(benchmark::State& state) {
+    push_back_growth<std::deque<int> >(state);
+}
+
+static void BM_chunked_queue_push_pop_front(benchmark::State& state) {
+    fdt::ChunkedDeque<int> q(3000);
+    for(auto _ : state) {
+        for(int i = 0; i < 3000; i++) {
+            q.push_back(i);
+            benchmark::DoNotOptimize(q.front());
+            q.pop_front();
+            q.push_front(i);
+            benchmark::DoNotOptimize(q.back());
+            q.pop_back();
+        }
+    }
+}
+
+static void BM_chunked_queue_random_access(benchmark::State& state) {
+    fdt::ChunkedDeque<int> q;
+    for (int i = 0; i < 1 << 20; i++) {
+        q.push_back(i);
+    }
+    size_t index = 0;
+    for (auto _ : state) {
+        index = (index * 1103515245 + 12345) & ((1 << 20) - 1);
+        benchmark::DoNotOptimize(q[index]);
+    }
+}
+
+BENCHMARK(BM_queue_push_back_growth)->Arg(1 << 16)->Arg(1 << 22);
+BENCHMARK(BM_incremental_queue_push_back_growth)->Arg(1 << 16)->Arg(1 << 22);
+BENCHMARK(BM_chunked_queue_push_back_growth)->Arg(1 << 16)->Arg(1 << 22);
+BENCHMARK(BM_std_queue_push_back_growth)->Arg(1 << 16)->Arg(1 << 22);
+BENCHMARK(BM_chunked_queue_push_pop_front);
+BENCHMARK(BM_chunked_queue_random_access);
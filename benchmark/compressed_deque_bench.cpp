@@ -0,0 +1,116 @@
+#include <benchmark/benchmark.h>
+#include <CompressedDeque.h>
+#include <Deque.h>
+#include <cstdint>
+
+// Timestamps one to two microseconds apart, about a millisecond at a time.
+const size_t ELEMENTS = 1 << 20;
+
+static uint64_t next_timestamp(uint64_t& x, uint64_t timestamp) {
+  x ^= x << 13;
+  x ^= x >> 7;
+  x ^= x << 17;
+  return timestamp + 1000 + x % 1000;
+}
+
+template <class Queue>
+static void fill(Queue& q) {
+  uint64_t x = 88172645463325252ULL;
+  uint64_t timestamp = 1700000000000000ULL;
+  for (size_t i = 0; i < ELEMENTS; i++) {
+    timestamp = next_timestamp(x, timestamp);
+    q.push_back(timestamp);
+  }
+}
+
+// Pushes a window's worth of timestamps and pops them again.
+static void BM_compressed_queue_push_pop(benchmark::State& state) {
+  fdt::CompressedDeque<uint64_t> q;
+  uint64_t x = 88172645463325252ULL;
+  uint64_t timestamp = 0;
+  for (auto _ : state) {
+    for (int i = 0; i < 4096; i++) {
+      timestamp = next_timestamp(x, timestamp);
+      q.push_back(timestamp);
+    }
+    for (int i = 0; i < 4096; i++) {
+      q.pop_front();
+    }
+  }
+  state.SetItemsProcessed(state.iterations() * 4096);
+}
+
+static void BM_queue_push_pop(benchmark::State& state) {
+  fdt::Deque<uint64_t> q;
+  uint64_t x = 88172645463325252ULL;
+  uint64_t timestamp = 0;
+  for (auto _ : state) {
+    for (int i = 0; i < 4096; i++) {
+      timestamp = next_timestamp(x, timestamp);
+      q.push_back(timestamp);
+    }
+    for (int i = 0; i < 4096; i++) {
+      q.pop_front();
+    }
+  }
+  state.SetItemsProcessed(state.iterations() * 4096);
+}
+
+static void BM_compressed_queue_scan(benchmark::State& state) {
+  fdt::CompressedDeque<uint64_t> q;
+  fill(q);
+  for (auto _ : state) {
+    uint64_t sum = 0;
+    q.for_each([&sum](uint64_t value) { sum += value; });
+    benchmark::DoNotOptimize(sum);
+  }
+  state.SetItemsProcessed(state.iterations() * ELEMENTS);
+  state.counters["bytes"] = q.memory_usage();
+}
+
+static void BM_queue_scan(benchmark::State& state) {
+  fdt::Deque<uint64_t> q;
+  fill(q);
+  for (auto _ : state) {
+    uint64_t sum = 0;
+    for (size_t i = 0; i < q.size(); i++) {
+      sum += q[i];
+    }
+    benchmark::DoNotOptimize(sum);
+  }
+  state.SetItemsProcessed(state.iterations() * ELEMENTS);
+  state.counters["bytes"] = q.capacity() * sizeof(uint64_t);
+}
+
+static void BM_compressed_queue_random_access(benchmark::State& state) {
+  fdt::CompressedDeque<uint64_t> q;
+  fill(q);
+  uint64_t x = 88172645463325252ULL;
+  for (auto _ : state) {
+    x ^= x << 13;
+    x ^= x >> 7;
+    x ^= x << 17;
+    benchmark::DoNotOptimize(q[x % ELEMENTS]);
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+
+static void BM_queue_random_access(benchmark::State& state) {
+  fdt::Deque<uint64_t> q;
+  fill(q);
+  uint64_t x = 88172645463325252ULL;
+  for (auto _ : state) {
+    x ^= x << 13;
+    x ^= x >> 7;
+    x ^= x << 17;
+    benchmark::DoNotOptimize(q[x % ELEMENTS]);
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+
+BENCHMARK(BM_compressed_queue_push_pop);
+BENCHMARK(BM_queue_push_pop);
+BENCHMARK(BM_compressed_queue_scan);
+BENCHMARK(BM_queue_scan);
+BENCHMARK(BM_compressed_queue_random_access);
+BENCHMARK(BM_queue_random_access);
@@ -0,0 +1,26 @@
+#include <benchmark/benchmark.h>
+#include <ConcurrentDeque.h>
+#include "MixedEnds.h"
+
+const int OPS_PER_THREAD = 20000;
+
+template <class Queue>
+static void bench_mixed_ends(benchmark::State& state) {
+  const int threads = state.range(0);
+  for (auto _ : state) {
+    Queue q;
+    fdt::run_threads(threads, [&q](int t) { fdt::mixed_ends(q, t, OPS_PER_THREAD); });
+  }
+  state.SetItemsProcessed(state.iterations() * threads * OPS_PER_THREAD * 2);
+}
+
+static void BM_concurrent_deque_mixed_ends(benchmark::State& state) {
+  bench_mixed_ends<fdt::ConcurrentDeque<int> >(state);
+}
+
+static void BM_mutex_queue_mixed_ends(benchmark::State& state) {
+  bench_mixed_ends<fdt::MutexDeque>(state);
+}
+
+BENCHMARK(BM_concurrent_deque_mixed_ends)->RangeMultiplier(2)->Range(2, 16)->UseRealTime();
+BENCHMARK(BM_mutex_queue_mixed_ends)->RangeMultiplier(2)->Range(2, 16)->UseRealTime();
@@ -5,6 +5,7 @@
 #include <thread>
 #include <chrono>
 #include <queue>
+#include <vector>
 
 const int ITER_TIME = 3000;
 
@@ -138,6 +139,50 @@ static void BM_std_queue_push_pop_front(benchmark::State& state) {
     }
 }
 
+static void BM_queue_insert_middle(benchmark::State& state) {
+    fdt::Deque<int> q(ITER_TIME * 2);
+    for(auto _ : state) {
+        state.PauseTiming();
+        q.clear();
+        for(int i = 0; i < ITER_TIME; i++) {
+            q.push_back(i);
+        }
+        state.ResumeTiming();
+        for(int i = 0; i < ITER_TIME / 10; i++) {
+            q.insert(q.begin() + (int) (q.size() / 3), i);
+        }
+    }
+}
+
+static void BM_std_queue_insert_middle(benchmark::State& state) {
+    std::deque<int> q;
+    for(auto _ : state) {
+        state.PauseTiming();
+        q.clear();
+        for(int i = 0; i < ITER_TIME; i++) {
+            q.push_back(i);
+        }
+        state.ResumeTiming();
+        for(int i = 0; i < ITER_TIME / 10; i++) {
+            q.insert(q.begin() + q.size() / 3, i);
+        }
+    }
+}
+
+static void BM_queue_insert_range_middle(benchmark::State& state) {
+    fdt::Deque<int> q(ITER_TIME * 2);
+    std::vector<int> values(ITER_TIME / 10, 1);
+    for(auto _ : state) {
+        state.PauseTiming();
+        q.clear();
+        for(int i = 0; i < ITER_TIME; i++) {
+            q.push_back(i);
+        }
+        state.ResumeTiming();
+        q.insert(q.begin() + (int) (q.size() / 3), values.begin(), values.end());
+    }
+}
+
 static void BM_queue_message_send_and_receive(benchmark::State& state) {
     fdt::LockfreeQueue<int> q(100);
     for(auto _ : state) {
@@ -200,6 +245,9 @@ static void BM_std_deque_message_send_and_receive(benchmark::State& state) {
 // BENCHMARK(BM_std_queue_pop_front);
 // BENCHMARK(BM_queue_push_pop_front);
 // BENCHMARK(BM_std_queue_push_pop_front);
+BENCHMARK(BM_queue_insert_middle);
+BENCHMARK(BM_std_queue_insert_middle);
+BENCHMARK(BM_queue_insert_range_middle);
 BENCHMARK(BM_queue_message_send_and_receive);
 BENCHMARK(BM_std_deque_message_send_and_receive);
 
@@ -0,0 +1,78 @@
+#include <benchmark/benchmark.h>
+#include <Deque.h>
+#include <FanInQueue.h>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+const int ITEMS_PER_PRODUCER = 100000;
+
+// N producer threads feed one consumer, either through per-producer shards of
+// a FanInQueue or through a single Deque behind a mutex.
+static void BM_fanin_queue(benchmark::State& state) {
+  const int producers = state.range(0);
+  for (auto _ : state) {
+    fdt::FanInQueue<int> q(producers);
+    std::vector<std::thread> threads;
+    for (int p = 0; p < producers; p++) {
+      threads.emplace_back([&q] {
+        fdt::FanInQueue<int>::Producer producer = q.register_producer();
+        for (int i = 0; i < ITEMS_PER_PRODUCER; i++) {
+          producer.push(i);
+        }
+      });
+    }
+    long sum = 0;
+    long remaining = (long) producers * ITEMS_PER_PRODUCER;
+    while (remaining > 0) {
+      size_t count = q.drain([&sum](int& value) { sum += value; });
+      if (count == 0) {
+        std::this_thread::yield();
+      }
+      remaining -= count;
+    }
+    for (std::thread& thread : threads) {
+      thread.join();
+    }
+    benchmark::DoNotOptimize(sum);
+  }
+  state.SetItemsProcessed(state.iterations() * producers * ITEMS_PER_PRODUCER);
+}
+
+static void BM_mutex_queue_fanin(benchmark::State& state) {
+  const int producers = state.range(0);
+  for (auto _ : state) {
+    fdt::Deque<int> q;
+    std::mutex mutex;
+    std::vector<std::thread> threads;
+    for (int p = 0; p < producers; p++) {
+      threads.emplace_back([&q, &mutex] {
+        for (int i = 0; i < ITEMS_PER_PRODUCER; i++) {
+          std::lock_guard<std::mutex> lock(mutex);
+          q.push_back(i);
+        }
+      });
+    }
+    long sum = 0;
+    long remaining = (long) producers * ITEMS_PER_PRODUCER;
+    while (remaining > 0) {
+      std::unique_lock<std::mutex> lock(mutex);
+      if (q.empty()) {
+        lock.unlock();
+        std::this_thread::yield();
+        continue;
+      }
+      sum += q.front();
+      q.pop_front();
+      remaining--;
+    }
+    for (std::thread& thread : threads) {
+      thread.join();
+    }
+    benchmark::DoNotOptimize(sum);
+  }
+  state.SetItemsProcessed(state.iterations() * producers * ITEMS_PER_PRODUCER);
+}
+
+BENCHMARK(BM_fanin_queue)->Arg(1)->Arg(2)->Arg(4)->Arg(8)->UseRealTime();
+BENCHMARK(BM_mutex_queue_fanin)->Arg(1)->Arg(2)->Arg(4)->Arg(8)->UseRealTime();
@@ -0,0 +1,61 @@
+#include <benchmark/benchmark.h>
+#include <Deque.h>
+#include <unistd.h>
+
+// Bytes make a round trip through a pipe: the deque writes CHUNK bytes from
+// its front and reads them back onto its back. The baseline goes through a
+// temporary buffer and pops and pushes byte by byte, the way socket buffers
+// were filled before read_from and write_to.
+const size_t CHUNK = 16384;
+const size_t BUFFERED = 3 * CHUNK / 2;
+
+static void fill(fdt::Deque<char>& q) {
+  for (size_t i = 0; i < BUFFERED; i++) {
+    q.push_back((char) i);
+  }
+}
+
+static void BM_deque_fd_bytewise(benchmark::State& state) {
+  int fds[2];
+  if (pipe(fds) != 0) {
+    state.SkipWithError("pipe failed");
+    return;
+  }
+  fdt::Deque<char> q;
+  fill(q);
+  static char buffer[CHUNK];
+  for (auto _ : state) {
+    for (size_t i = 0; i < CHUNK; i++) {
+      buffer[i] = q.front();
+      q.pop_front();
+    }
+    benchmark::DoNotOptimize(write(fds[1], buffer, CHUNK));
+    ssize_t count = read(fds[0], buffer, CHUNK);
+    for (ssize_t i = 0; i < count; i++) {
+      q.push_back(buffer[i]);
+    }
+  }
+  close(fds[0]);
+  close(fds[1]);
+  state.SetBytesProcessed(state.iterations() * CHUNK);
+}
+
+static void BM_deque_fd_vectored(benchmark::State& state) {
+  int fds[2];
+  if (pipe(fds) != 0) {
+    state.SkipWithError("pipe failed");
+    return;
+  }
+  fdt::Deque<char> q;
+  fill(q);
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(q.write_to(fds[1], CHUNK));
+    benchmark::DoNotOptimize(q.read_from(fds[0], CHUNK));
+  }
+  close(fds[0]);
+  close(fds[1]);
+  state.SetBytesProcessed(state.iterations() * CHUNK);
+}
+
+BENCHMARK(BM_deque_fd_bytewise);
+BENCHMARK(BM_deque_fd_vectored);
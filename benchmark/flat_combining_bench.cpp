@@ -0,0 +1,41 @@
+#include <benchmark/benchmark.h>
+#include <ConcurrentDeque.h>
+#include <FlatCombiningDeque.h>
+#include "MixedEnds.h"
+
+// Every thread pushes and pops at alternating ends, as in
+// concurrent_deque_bench.cpp. The argument is the number of threads. The
+// repo's lock-free queues are single-consumer, so the multi-consumer
+// ConcurrentDeque stands in for them.
+const int OPS_PER_THREAD = 5000;
+
+static void BM_flat_combining_deque(benchmark::State& state) {
+  for (auto _ : state) {
+    fdt::FlatCombiningDeque<int> q(state.range(0));
+    fdt::run_threads(state.range(0), [&q](int t) {
+      fdt::FlatCombiningDeque<int>::Handle handle = q.register_thread();
+      fdt::mixed_ends(handle, t, OPS_PER_THREAD);
+    });
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0) * OPS_PER_THREAD * 2);
+}
+
+static void BM_mutex_deque(benchmark::State& state) {
+  for (auto _ : state) {
+    fdt::MutexDeque q;
+    fdt::run_threads(state.range(0), [&q](int t) { fdt::mixed_ends(q, t, OPS_PER_THREAD); });
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0) * OPS_PER_THREAD * 2);
+}
+
+static void BM_split_lock_deque(benchmark::State& state) {
+  for (auto _ : state) {
+    fdt::ConcurrentDeque<int> q;
+    fdt::run_threads(state.range(0), [&q](int t) { fdt::mixed_ends(q, t, OPS_PER_THREAD); });
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0) * OPS_PER_THREAD * 2);
+}
+
+BENCHMARK(BM_flat_combining_deque)->RangeMultiplier(2)->Range(8, 64)->UseRealTime();
+BENCHMARK(BM_mutex_deque)->RangeMultiplier(2)->Range(8, 64)->UseRealTime();
+BENCHMARK(BM_split_lock_deque)->RangeMultiplier(2)->Range(8, 64)->UseRealTime();
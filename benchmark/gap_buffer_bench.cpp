@@ -0,0 +1,58 @@
+#include <benchmark/benchmark.h>
+#include <Deque.h>
+#include <algorithm>
+
+// A deque of 100000 elements takes bursts of inserts and erases at an edit
+// cursor. Clustered edits move the cursor by a few positions at a time, as
+// in a text editor or an order book; random edits jump anywhere. Inserts and
+// erases alternate so the size stays put.
+const int ELEMENTS = 100000;
+const int EDITS = 1000;
+
+static size_t next_cursor(unsigned& x, size_t cursor, bool clustered) {
+  x = x * 1103515245 + 12345;
+  if (!clustered) {
+    return (x >> 8) % (ELEMENTS - 1);
+  }
+  size_t step = (x >> 8) % 9;
+  return std::min((size_t) ELEMENTS - 2, cursor + step >= 4 ? cursor + step - 4 : 0);
+}
+
+static void edit(benchmark::State& state, bool gap_buffer, bool clustered) {
+  fdt::Deque<int> q;
+  q.set_gap_buffer(gap_buffer);
+  for (int i = 0; i < ELEMENTS; i++) {
+    q.push_back(i);
+  }
+  unsigned x = 1;
+  size_t cursor = ELEMENTS / 2;
+  for (auto _ : state) {
+    for (int i = 0; i < EDITS; i++) {
+      cursor = next_cursor(x, cursor, clustered);
+      q.insert(q.begin() + (int) cursor, i);
+      q.erase(q.begin() + (int) cursor + 1);
+    }
+  }
+  state.SetItemsProcessed(state.iterations() * EDITS * 2);
+}
+
+static void BM_shift_clustered_edits(benchmark::State& state) {
+  edit(state, false, true);
+}
+
+static void BM_gap_buffer_clustered_edits(benchmark::State& state) {
+  edit(state, true, true);
+}
+
+static void BM_shift_random_edits(benchmark::State& state) {
+  edit(state, false, false);
+}
+
+static void BM_gap_buffer_random_edits(benchmark::State& state) {
+  edit(state, true, false);
+}
+
+BENCHMARK(BM_shift_clustered_edits);
+BENCHMARK(BM_gap_buffer_clustered_edits);
+BENCHMARK(BM_shift_random_edits);
+BENCHMARK(BM_gap_buffer_random_edits);
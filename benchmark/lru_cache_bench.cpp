@@ -0,0 +1,106 @@
+#include <benchmark/benchmark.h>
+#include <Deque.h>
+#include <LruCache.h>
+#include <cstdint>
+#include <iterator>
+#include <list>
+#include <unordered_map>
+#include <vector>
+
+// Each iteration looks up a key and inserts it on a miss. Keys are drawn from
+// twice the capacity with a skew towards small keys, so both hits, which
+// promote, and misses, which evict, are frequent. The argument is the capacity.
+static std::vector<uint64_t> keys(size_t capacity) {
+  std::vector<uint64_t> keys(1 << 16);
+  uint64_t x = 88172645463325252ULL;
+  for (uint64_t& key : keys) {
+    x ^= x << 13;
+    x ^= x >> 7;
+    x ^= x << 17;
+    uint64_t a = x % (2 * capacity);
+    uint64_t b = (x >> 32) % (2 * capacity);
+    key = a < b ? a : b;
+  }
+  return keys;
+}
+
+static void BM_lru_cache(benchmark::State& state) {
+  const size_t capacity = state.range(0);
+  std::vector<uint64_t> trace = keys(capacity);
+  fdt::LruCache<uint64_t, uint64_t> cache(capacity);
+  size_t i = 0;
+  for (auto _ : state) {
+    uint64_t key = trace[i++ & (trace.size() - 1)];
+    uint64_t* value = cache.get(key);
+    if (value == nullptr) {
+      cache.put(key, key);
+    } else {
+      benchmark::DoNotOptimize(*value);
+    }
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+
+// The pattern LruCache replaces: order in a Deque, positions in a map. A hit
+// erases from the middle of the deque, which shifts elements and forces every
+// stored position behind it to be rewritten.
+static void BM_deque_unordered_map(benchmark::State& state) {
+  const size_t capacity = state.range(0);
+  std::vector<uint64_t> trace = keys(capacity);
+  fdt::Deque<uint64_t> order(capacity * 2);
+  std::unordered_map<uint64_t, std::pair<size_t, uint64_t>> index;
+  size_t i = 0;
+  for (auto _ : state) {
+    uint64_t key = trace[i++ & (trace.size() - 1)];
+    auto it = index.find(key);
+    if (it != index.end()) {
+      size_t position = it->second.first;
+      order.erase(order.begin() + position);
+      for (size_t j = position; j < order.size(); j++) {
+        index[order[j]].first = j;
+      }
+      it->second.first = order.size();
+      order.push_back(key);
+      benchmark::DoNotOptimize(it->second.second);
+    } else {
+      if (order.size() == capacity) {
+        index.erase(order.front());
+        order.pop_front();
+        for (auto& entry : index) {
+          entry.second.first--;
+        }
+      }
+      index[key] = std::make_pair(order.size(), key);
+      order.push_back(key);
+    }
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+
+static void BM_list_unordered_map(benchmark::State& state) {
+  const size_t capacity = state.range(0);
+  std::vector<uint64_t> trace = keys(capacity);
+  std::list<std::pair<uint64_t, uint64_t>> order;
+  std::unordered_map<uint64_t, std::list<std::pair<uint64_t, uint64_t>>::iterator> index;
+  size_t i = 0;
+  for (auto _ : state) {
+    uint64_t key = trace[i++ & (trace.size() - 1)];
+    auto it = index.find(key);
+    if (it != index.end()) {
+      order.splice(order.end(), order, it->second);
+      benchmark::DoNotOptimize(it->second->second);
+    } else {
+      if (order.size() == capacity) {
+        index.erase(order.front().first);
+        order.pop_front();
+      }
+      order.emplace_back(key, key);
+      index[key] = std::prev(order.end());
+    }
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+
+BENCHMARK(BM_lru_cache)->Arg(1 << 8)->Arg(1 << 12);
+BENCHMARK(BM_deque_unordered_map)->Arg(1 << 8)->Arg(1 << 12);
+BENCHMARK(BM_list_unordered_map)->Arg(1 << 8)->Arg(1 << 12);
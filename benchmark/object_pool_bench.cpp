@@ -0,0 +1,63 @@
+#include <benchmark/benchmark.h>
+#include <LockfreeQueue.h>
+#include <ObjectPool.h>
+#include <cstdint>
+#include <thread>
+
+// The producer/consumer exchange of deque_bench.cpp with heap messages: the
+// producer fills a message and sends its pointer through a LockfreeQueue,
+// and the consumer reads it and gives it back, either to the allocator or to
+// the pool.
+const int MESSAGES = 100000;
+
+struct Envelope {
+  uint64_t sequence;
+  char payload[248];
+};
+
+template <class Acquire, class Release>
+static void exchange(benchmark::State& state, Acquire acquire, Release release) {
+  for (auto _ : state) {
+    fdt::LockfreeQueue<Envelope*> q(100);
+    std::thread consumer([&q, &release] {
+      uint64_t sum = 0;
+      for (int i = 0; i < MESSAGES; i++) {
+        while (q.empty()) {
+          std::this_thread::yield();
+        }
+        Envelope* message = q.front();
+        q.pop_front();
+        sum += message->sequence + message->payload[0];
+        release(message);
+      }
+      benchmark::DoNotOptimize(sum);
+    });
+    for (int i = 0; i < MESSAGES; i++) {
+      Envelope* message;
+      while ((message = acquire()) == nullptr) {
+        std::this_thread::yield();
+      }
+      message->sequence = i;
+      message->payload[0] = (char) i;
+      while (q.full()) {
+        std::this_thread::yield();
+      }
+      q.push_back(message);
+    }
+    consumer.join();
+  }
+  state.SetItemsProcessed(state.iterations() * MESSAGES);
+}
+
+static void BM_messages_new_delete(benchmark::State& state) {
+  exchange(state, [] { return new Envelope; }, [](Envelope* message) { delete message; });
+}
+
+static void BM_messages_object_pool(benchmark::State& state) {
+  fdt::ObjectPool<Envelope> pool(64, 1024);
+  exchange(state, [&pool] { return pool.acquire(); },
+      [&pool](Envelope* message) { pool.release(message); });
+}
+
+BENCHMARK(BM_messages_new_delete)->UseRealTime();
+BENCHMARK(BM_messages_object_pool)->UseRealTime();
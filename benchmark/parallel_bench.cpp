@@ -0,0 +1,73 @@
+#include <benchmark/benchmark.h>
+#include <Deque.h>
+#include <ParallelAlgorithms.h>
+#include <algorithm>
+#include <cstdint>
+
+const size_t ELEMENTS = 1 << 22;
+
+// The deque is filled from both ends so that its elements wrap around the
+// buffer. The argument is the number of threads; 1 is the serial baseline.
+static void fill(fdt::Deque<uint64_t>& q) {
+  uint64_t x = 88172645463325252ULL;
+  for (size_t i = 0; i < ELEMENTS; i++) {
+    x ^= x << 13;
+    x ^= x >> 7;
+    x ^= x << 17;
+    if (i % 2 == 0) {
+      q.push_back(x);
+    } else {
+      q.push_front(x);
+    }
+  }
+}
+
+static fdt::ParallelOptions options(benchmark::State& state) {
+  fdt::ParallelOptions options;
+  options.threads = state.range(0);
+  return options;
+}
+
+static void BM_parallel_for_each(benchmark::State& state) {
+  fdt::Deque<uint64_t> q;
+  fill(q);
+  for (auto _ : state) {
+    fdt::parallel_for_each(q, [](uint64_t& value) { value = value * 31 + 7; }, options(state));
+  }
+  state.SetItemsProcessed(state.iterations() * ELEMENTS);
+}
+
+static void BM_parallel_reduce(benchmark::State& state) {
+  fdt::Deque<uint64_t> q;
+  fill(q);
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(fdt::parallel_reduce(q, (uint64_t) 0, options(state)));
+  }
+  state.SetItemsProcessed(state.iterations() * ELEMENTS);
+}
+
+static void BM_parallel_transform(benchmark::State& state) {
+  fdt::Deque<uint64_t> q;
+  fdt::Deque<double> out;
+  fill(q);
+  for (auto _ : state) {
+    fdt::parallel_transform(q, out, [](uint64_t value) { return value * 0.5; }, options(state));
+  }
+  state.SetItemsProcessed(state.iterations() * ELEMENTS);
+}
+
+static void BM_parallel_sort(benchmark::State& state) {
+  for (auto _ : state) {
+    state.PauseTiming();
+    fdt::Deque<uint64_t> q;
+    fill(q);
+    state.ResumeTiming();
+    fdt::parallel_sort(q, options(state));
+  }
+  state.SetItemsProcessed(state.iterations() * ELEMENTS);
+}
+
+BENCHMARK(BM_parallel_for_each)->Arg(1)->Arg(2)->Arg(4)->Arg(8)->UseRealTime();
+BENCHMARK(BM_parallel_reduce)->Arg(1)->Arg(2)->Arg(4)->Arg(8)->UseRealTime();
+BENCHMARK(BM_parallel_transform)->Arg(1)->Arg(2)->Arg(4)->Arg(8)->UseRealTime();
+BENCHMARK(BM_parallel_sort)->Arg(1)->Arg(2)->Arg(4)->Arg(8)->UseRealTime();
@@ -0,0 +1,88 @@
+#include <benchmark/benchmark.h>
+#include <LockfreeQueue.h>
+#include <PriorityLaneQueue.h>
+#include <cstdint>
+
+// Each iteration queues 1000 bulk messages with 10 control messages spread
+// among them and then drains everything. control_rank is the average number
+// of messages consumed before each control message: with a single FIFO ring
+// control waits behind the bulk queued ahead of it.
+const int BULK = 1000;
+const int CONTROL = 10;
+
+struct Message {
+  uint32_t lane;
+  uint32_t bytes;
+};
+
+struct MessageBytes {
+  size_t operator()(const Message& message) const {
+    return message.bytes;
+  }
+};
+
+static void BM_single_ring(benchmark::State& state) {
+  fdt::LockfreeQueue<Message> q(2048);
+  double rank = 0;
+  for (auto _ : state) {
+    for (int i = 0; i < BULK; i++) {
+      q.push_back(Message{1, 1500});
+      if (i % (BULK / CONTROL) == 0) {
+        q.push_back(Message{0, 64});
+      }
+    }
+    for (int consumed = 0; !q.empty(); consumed++) {
+      if (q.front().lane == 0) {
+        rank += consumed;
+      }
+      q.pop_front();
+    }
+  }
+  state.SetItemsProcessed(state.iterations() * (BULK + CONTROL));
+  state.counters["control_rank"] = rank / (state.iterations() * CONTROL);
+}
+
+template <fdt::LanePolicy Policy>
+static void lanes(benchmark::State& state) {
+  fdt::PriorityLaneQueue<Message, 2, MessageBytes> q(2048, Policy);
+  // Control gets a fifth of the consumer: one message against four bulk ones
+  // under weighted round-robin, 1500 bytes against 6000 under deficit.
+  size_t unit = Policy == fdt::LanePolicy::DeficitRoundRobin ? 1500 : 1;
+  q.set_weight(0, unit);
+  q.set_weight(1, 4 * unit);
+  double rank = 0;
+  for (auto _ : state) {
+    for (int i = 0; i < BULK; i++) {
+      q.push(1, Message{1, 1500});
+      if (i % (BULK / CONTROL) == 0) {
+        q.push(0, Message{0, 64});
+      }
+    }
+    int consumed = 0;
+    q.drain([&rank, &consumed](Message& message) {
+      if (message.lane == 0) {
+        rank += consumed;
+      }
+      consumed++;
+    }, BULK + CONTROL);
+  }
+  state.SetItemsProcessed(state.iterations() * (BULK + CONTROL));
+  state.counters["control_rank"] = rank / (state.iterations() * CONTROL);
+}
+
+static void BM_lanes_strict(benchmark::State& state) {
+  lanes<fdt::LanePolicy::Strict>(state);
+}
+
+static void BM_lanes_weighted_round_robin(benchmark::State& state) {
+  lanes<fdt::LanePolicy::WeightedRoundRobin>(state);
+}
+
+static void BM_lanes_deficit_round_robin(benchmark::State& state) {
+  lanes<fdt::LanePolicy::DeficitRoundRobin>(state);
+}
+
+BENCHMARK(BM_single_ring);
+BENCHMARK(BM_lanes_strict);
+BENCHMARK(BM_lanes_weighted_round_robin);
+BENCHMARK(BM_lanes_deficit_round_robin);
@@ -0,0 +1,301 @@
+#include "LatencyHistogram.h"
+
+#include <LockfreeQueue.h>
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <thread>
+
+#if defined(__linux__)
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define FDT_HAVE_TSC 1
+#endif
+
+// Per-message latency harness for the concurrent queues. Every message
+// carries the time it was sent; the receiving side records the difference in
+// a log-linear histogram so the tail (p99/p99.9/max) is reported instead of a
+// single throughput number.
+//
+//   VDEQUE_LATENCY --mode=oneway|pingpong --messages=N --warmup=N
+//                  --capacity=N --interval-ns=N --clock=steady|tsc
+//                  --producer-core=N --consumer-core=N --yield-after=N
+
+namespace {
+
+struct Stamp {
+  uint64_t sent;
+  uint64_t seq;
+};
+
+// Adapter between the harness and a queue type. Queues that do not follow the
+// LockfreeQueue push_back/front/pop_front protocol specialize this.
+template <typename Queue>
+struct LatencyQueueOps {
+  static bool try_send(Queue& q, const Stamp& stamp) {
+    if (q.full()) {
+      return false;
+    }
+    q.push_back(stamp);
+    return true;
+  }
+
+  static bool try_receive(Queue& q, Stamp& stamp) {
+    if (q.empty()) {
+      return false;
+    }
+    stamp = q.front();
+    q.pop_front();
+    return true;
+  }
+};
+
+struct Options {
+  std::string mode = "oneway";
+  std::string clock = "steady";
+  uint64_t messages = 1000000;
+  uint64_t warmup = 10000;
+  size_t capacity = 1024;
+  uint64_t interval_ns = 1000;
+  int producer_core = -1;
+  int consumer_core = -1;
+  uint64_t yield_after = 0;
+};
+
+class Clock {
+public:
+  explicit Clock(bool tsc) : tsc_(tsc), ns_per_tick_(1.0) {
+#ifdef FDT_HAVE_TSC
+    if (tsc_) {
+      calibrate();
+    }
+#else
+    tsc_ = false;
+#endif
+  }
+
+  uint64_t now() const {
+#ifdef FDT_HAVE_TSC
+    if (tsc_) {
+      return __rdtsc();
+    }
+#endif
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+  }
+
+  uint64_t to_ns(uint64_t ticks) const {
+    return tsc_ ? (uint64_t) (ticks * ns_per_tick_) : ticks;
+  }
+
+  const char* name() const {
+    return tsc_ ? "tsc" : "steady_clock";
+  }
+
+private:
+  bool tsc_;
+  double ns_per_tick_;
+
+#ifdef FDT_HAVE_TSC
+  void calibrate() {
+    std::chrono::steady_clock::time_point begin = std::chrono::steady_clock::now();
+    uint64_t ticks = __rdtsc();
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    ticks = __rdtsc() - ticks;
+    double ns = std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now() - begin).count();
+    ns_per_tick_ = ns / ticks;
+  }
+#endif
+};
+
+void pin_thread(int core) {
+  if (core < 0) {
+    return;
+  }
+#if defined(__linux__)
+  cpu_set_t set;
+  CPU_ZERO(&set);
+  CPU_SET(core, &set);
+  if (pthread_setaffinity_np(pthread_self(), sizeof(set), &set) != 0) {
+    std::cerr << "warning: cannot pin thread to core " << core << std::endl;
+  }
+#else
+  std::cerr << "warning: thread pinning is not supported on this platform" << std::endl;
+#endif
+}
+
+// Busy-waits on `ready`; with yield_after != 0 the waiter gives up its time
+// slice every yield_after polls, which is needed when both threads share a core.
+template <typename Ready>
+void spin_until(Ready ready, uint64_t yield_after) {
+  uint64_t spins = 0;
+  while (!ready()) {
+    if (yield_after != 0 && ++spins % yield_after == 0) {
+      std::this_thread::yield();
+    }
+  }
+}
+
+template <typename Queue>
+void run_oneway(const Options& options, const Clock& clock,
+    fdt::LatencyHistogram<>& histogram) {
+  typedef LatencyQueueOps<Queue> Ops;
+  Queue queue(options.capacity);
+  uint64_t total = options.warmup + options.messages;
+  std::atomic<bool> consumer_ready(false);
+
+  std::thread consumer([&] {
+    pin_thread(options.consumer_core);
+    consumer_ready.store(true);
+    Stamp stamp;
+    for (uint64_t i = 0; i < total; i++) {
+      spin_until([&] { return Ops::try_receive(queue, stamp); }, options.yield_after);
+      uint64_t received = clock.now();
+      if (stamp.seq >= options.warmup) {
+        histogram.record(clock.to_ns(received - stamp.sent));
+      }
+    }
+  });
+
+  pin_thread(options.producer_core);
+  spin_until([&] { return consumer_ready.load(); }, options.yield_after);
+  std::chrono::steady_clock::time_point next = std::chrono::steady_clock::now();
+  for (uint64_t i = 0; i < total; i++) {
+    if (options.interval_ns != 0) {
+      next += std::chrono::nanoseconds(options.interval_ns);
+      spin_until([&] { return std::chrono::steady_clock::now() >= next; },
+          options.yield_after);
+    }
+    Stamp stamp;
+    stamp.seq = i;
+    stamp.sent = clock.now();
+    spin_until([&] { return Ops::try_send(queue, stamp); }, options.yield_after);
+  }
+  consumer.join();
+}
+
+template <typename Queue>
+void run_pingpong(const Options& options, const Clock& clock,
+    fdt::LatencyHistogram<>& histogram) {
+  typedef LatencyQueueOps<Queue> Ops;
+  Queue ping(options.capacity);
+  Queue pong(options.capacity);
+  uint64_t total = options.warmup + options.messages;
+
+  std::thread echo([&] {
+    pin_thread(options.consumer_core);
+    Stamp stamp;
+    for (uint64_t i = 0; i < total; i++) {
+      spin_until([&] { return Ops::try_receive(ping, stamp); }, options.yield_after);
+      spin_until([&] { return Ops::try_send(pong, stamp); }, options.yield_after);
+    }
+  });
+
+  pin_thread(options.producer_core);
+  for (uint64_t i = 0; i < total; i++) {
+    Stamp stamp;
+    stamp.seq = i;
+    stamp.sent = clock.now();
+    spin_until([&] { return Ops::try_send(ping, stamp); }, options.yield_after);
+    spin_until([&] { return Ops::try_receive(pong, stamp); }, options.yield_after);
+    uint64_t received = clock.now();
+    if (stamp.seq >= options.warmup) {
+      histogram.record(clock.to_ns(received - stamp.sent));
+    }
+  }
+  echo.join();
+}
+
+bool parse_option(const char* arg, const char* name, std::string& value) {
+  size_t length = std::strlen(name);
+  if (std::strncmp(arg, name, length) != 0 || arg[length] != '=') {
+    return false;
+  }
+  value = arg + length + 1;
+  return true;
+}
+
+void usage(const char* program) {
+  std::cerr << "usage: " << program
+            << " [--mode=oneway|pingpong] [--messages=N] [--warmup=N]"
+            << " [--capacity=N] [--interval-ns=N] [--clock=steady|tsc]"
+            << " [--producer-core=N] [--consumer-core=N] [--yield-after=N]"
+            << std::endl;
+}
+
+bool parse_options(int argc, char** argv, Options& options) {
+  for (int i = 1; i < argc; i++) {
+    std::string value;
+    if (parse_option(argv[i], "--mode", value)) {
+      options.mode = value;
+    }
+    else if (parse_option(argv[i], "--clock", value)) {
+      options.clock = value;
+    }
+    else if (parse_option(argv[i], "--messages", value)) {
+      options.messages = std::strtoull(value.c_str(), nullptr, 10);
+    }
+    else if (parse_option(argv[i], "--warmup", value)) {
+      options.warmup = std::strtoull(value.c_str(), nullptr, 10);
+    }
+    else if (parse_option(argv[i], "--capacity", value)) {
+      options.capacity = std::strtoull(value.c_str(), nullptr, 10);
+    }
+    else if (parse_option(argv[i], "--interval-ns", value)) {
+      options.interval_ns = std::strtoull(value.c_str(), nullptr, 10);
+    }
+    else if (parse_option(argv[i], "--producer-core", value)) {
+      options.producer_core = std::atoi(value.c_str());
+    }
+    else if (parse_option(argv[i], "--consumer-core", value)) {
+      options.consumer_core = std::atoi(value.c_str());
+    }
+    else if (parse_option(argv[i], "--yield-after", value)) {
+      options.yield_after = std::strtoull(value.c_str(), nullptr, 10);
+    }
+    else {
+      return false;
+    }
+  }
+  return (options.mode == "oneway" || options.mode == "pingpong")
+      && (options.clock == "steady" || options.clock == "tsc")
+      && options.capacity != 0;
+}
+
+}
+
+int main(int argc, char** argv) {
+  Options options;
+  if (!parse_options(argc, argv, options)) {
+    usage(argv[0]);
+    return 1;
+  }
+
+  Clock clock(options.clock == "tsc");
+  fdt::LatencyHistogram<> histogram;
+  if (options.mode == "pingpong") {
+    run_pingpong<fdt::LockfreeQueue<Stamp> >(options, clock, histogram);
+  }
+  else {
+    run_oneway<fdt::LockfreeQueue<Stamp> >(options, clock, histogram);
+  }
+
+  std::cout << "queue LockfreeQueue mode " << options.mode
+            << " clock " << clock.name()
+            << " capacity " << options.capacity
+            << " interval " << options.interval_ns << " ns"
+            << (options.mode == "pingpong" ? " (round trip)" : " (one way)")
+            << std::endl;
+  histogram.print(std::cout, "ns");
+  return 0;
+}
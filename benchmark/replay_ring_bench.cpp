@@ -0,0 +1,64 @@
+#include <benchmark/benchmark.h>
+#include <Deque.h>
+#include <ReplayRing.h>
+#include <algorithm>
+#include <cstdint>
+
+// 4096 sent messages are kept for retransmission and every iteration answers
+// one NAK for a message somewhere in that window. Without stable sequences
+// the buffer is scanned for the message carrying the requested number.
+const size_t WINDOW = 4096;
+
+struct Packet {
+  uint64_t sequence;
+  char payload[56];
+};
+
+static uint64_t nak(uint64_t& x) {
+  x = x * 6364136223846793005ULL + 1442695040888963407ULL;
+  return (x >> 33) % WINDOW;
+}
+
+static void BM_nak_deque_scan(benchmark::State& state) {
+  fdt::Deque<Packet> sent(2 * WINDOW);
+  for (uint64_t i = 0; i < WINDOW; i++) {
+    sent.push_back(Packet{i, {}});
+  }
+  uint64_t x = 1;
+  for (auto _ : state) {
+    uint64_t wanted = nak(x);
+    benchmark::DoNotOptimize(std::find_if(sent.begin(), sent.end(),
+        [wanted](const Packet& packet) { return packet.sequence == wanted; }));
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+
+static void BM_nak_replay_ring(benchmark::State& state) {
+  fdt::ReplayRing<Packet> sent(WINDOW);
+  for (uint64_t i = 0; i < WINDOW; i++) {
+    sent.push(Packet{i, {}});
+  }
+  uint64_t x = 1;
+  Packet packet;
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(sent.get(nak(x), packet));
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+
+static void BM_nak_concurrent_replay_ring(benchmark::State& state) {
+  fdt::ConcurrentReplayRing<Packet> sent(WINDOW);
+  for (uint64_t i = 0; i < WINDOW; i++) {
+    sent.push(Packet{i, {}});
+  }
+  uint64_t x = 1;
+  Packet packet;
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(sent.get(nak(x), packet));
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+
+BENCHMARK(BM_nak_deque_scan);
+BENCHMARK(BM_nak_replay_ring);
+BENCHMARK(BM_nak_concurrent_replay_ring);
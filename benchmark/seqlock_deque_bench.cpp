@@ -0,0 +1,87 @@
+#include <benchmark/benchmark.h>
+#include <Deque.h>
+#include <SeqlockDeque.h>
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// The writer keeps a window of about 4096 values, appending and trimming the
+// front, while the argument's number of reader threads copy the newest 256
+// values over and over. The time measured is the writer's.
+const size_t WINDOW = 4096;
+const size_t READ = 256;
+
+class LockedWindow {
+public:
+  void push_back(uint64_t value) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    deque_.push_back(value);
+  }
+
+  void pop_front() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    deque_.pop_front();
+  }
+
+  size_t read(size_t index, size_t count, uint64_t* out) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    size_t copied = 0;
+    for (size_t i = index; i < deque_.size() && copied < count; i++) {
+      out[copied++] = deque_[i];
+    }
+    return copied;
+  }
+
+  size_t size() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return deque_.size();
+  }
+
+private:
+  std::mutex mutex_;
+  fdt::Deque<uint64_t> deque_;
+};
+
+template <class Queue>
+static void writer_with_readers(benchmark::State& state) {
+  Queue q;
+  for (size_t i = 0; i < WINDOW; i++) {
+    q.push_back(i);
+  }
+  std::atomic<bool> done(false);
+  std::vector<std::thread> readers;
+  for (int r = 0; r < state.range(0); r++) {
+    readers.emplace_back([&q, &done] {
+      std::vector<uint64_t> out(READ);
+      while (!done.load(std::memory_order_relaxed)) {
+        size_t size = q.size();
+        benchmark::DoNotOptimize(q.read(size > READ ? size - READ : 0, READ, out.data()));
+      }
+    });
+  }
+  uint64_t value = WINDOW;
+  for (auto _ : state) {
+    for (int i = 0; i < 1000; i++) {
+      q.push_back(value++);
+      q.pop_front();
+    }
+  }
+  done.store(true);
+  for (std::thread& reader : readers) {
+    reader.join();
+  }
+  state.SetItemsProcessed(state.iterations() * 1000);
+}
+
+static void BM_seqlock_queue_writer(benchmark::State& state) {
+  writer_with_readers<fdt::SeqlockDeque<uint64_t>>(state);
+}
+
+static void BM_mutex_queue_writer(benchmark::State& state) {
+  writer_with_readers<LockedWindow>(state);
+}
+
+BENCHMARK(BM_seqlock_queue_writer)->Arg(0)->Arg(1)->Arg(2)->UseRealTime();
+BENCHMARK(BM_mutex_queue_writer)->Arg(0)->Arg(1)->Arg(2)->UseRealTime();
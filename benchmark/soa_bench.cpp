@@ -0,0 +1,88 @@
+#include <benchmark/benchmark.h>
+#include <Deque.h>
+#include <SoaDeque.h>
+#include <cstdint>
+
+struct Record {
+  uint64_t timestamp;
+  double price;
+  uint32_t qty;
+  uint32_t flags;
+};
+
+// Sums one field over every record: with a Deque of records each cache line
+// carries three other fields, with SoaDeque the scan reads prices only. The
+// deque is rotated so both containers wrap around the end of their buffer.
+static void BM_queue_record_field_scan(benchmark::State& state) {
+  const size_t count = state.range(0);
+  fdt::Deque<Record> q(count * 2);
+  for (size_t i = 0; i < count + count / 2; i++) {
+    q.push_back(Record{i, i * 0.5, (uint32_t) i, 0});
+  }
+  for (size_t i = 0; i < count / 2; i++) {
+    q.pop_front();
+  }
+  for (auto _ : state) {
+    double sum = 0;
+    for (size_t i = 0; i < count; i++) {
+      sum += q[i].price;
+    }
+    benchmark::DoNotOptimize(sum);
+  }
+  state.SetItemsProcessed(state.iterations() * count);
+}
+
+static void BM_soa_queue_field_scan(benchmark::State& state) {
+  const size_t count = state.range(0);
+  fdt::SoaDeque<uint64_t, double, uint32_t, uint32_t> q(count * 2);
+  for (size_t i = 0; i < count + count / 2; i++) {
+    q.push_back(i, i * 0.5, (uint32_t) i, 0);
+  }
+  for (size_t i = 0; i < count / 2; i++) {
+    q.pop_front();
+  }
+  for (auto _ : state) {
+    fdt::Segments<const double> prices =
+        static_cast<const fdt::SoaDeque<uint64_t, double, uint32_t, uint32_t>&>(q).column<1>();
+    double sum = 0;
+    for (double price : prices.first) {
+      sum += price;
+    }
+    for (double price : prices.second) {
+      sum += price;
+    }
+    benchmark::DoNotOptimize(sum);
+  }
+  state.SetItemsProcessed(state.iterations() * count);
+}
+
+static void BM_soa_queue_push_pop(benchmark::State& state) {
+  fdt::SoaDeque<uint64_t, double, uint32_t, uint32_t> q;
+  for (auto _ : state) {
+    for (uint32_t i = 0; i < 1000; i++) {
+      q.push_back(i, i * 0.5, i, 0);
+    }
+    for (int i = 0; i < 1000; i++) {
+      q.pop_front();
+    }
+  }
+  state.SetItemsProcessed(state.iterations() * 1000);
+}
+
+static void BM_queue_record_push_pop(benchmark::State& state) {
+  fdt::Deque<Record> q;
+  for (auto _ : state) {
+    for (uint32_t i = 0; i < 1000; i++) {
+      q.push_back(Record{i, i * 0.5, i, 0});
+    }
+    for (int i = 0; i < 1000; i++) {
+      q.pop_front();
+    }
+  }
+  state.SetItemsProcessed(state.iterations() * 1000);
+}
+
+BENCHMARK(BM_queue_record_field_scan)->Arg(1 << 12)->Arg(1 << 20);
+BENCHMARK(BM_soa_queue_field_scan)->Arg(1 << 12)->Arg(1 << 20);
+BENCHMARK(BM_queue_record_push_pop);
+BENCHMARK(BM_soa_queue_push_pop);
@@ -0,0 +1,162 @@
+#include <benchmark/benchmark.h>
+#include <TimingWheel.h>
+#include <cstdint>
+#include <functional>
+#include <queue>
+#include <vector>
+
+// One million timers stay active. Each iteration schedules a timer 1 to 32767
+// ticks ahead and, in the cancel benchmarks, cancels a random live one. Time
+// moves forward one tick every 32 iterations, which in the expire benchmarks
+// fires about as many timers as are scheduled.
+const size_t ACTIVE = 1 << 20;
+const uint64_t HORIZON = 1 << 15;
+
+struct Random {
+  uint64_t x = 88172645463325252ULL;
+
+  uint64_t next() {
+    x ^= x << 13;
+    x ^= x >> 7;
+    x ^= x << 17;
+    return x;
+  }
+};
+
+// The usual alternative: a binary heap, with cancellation by generation.
+class HeapTimers {
+public:
+  fdt::TimerHandle schedule(uint64_t deadline, uint64_t value) {
+    uint32_t index;
+    if (free_.empty()) {
+      index = (uint32_t) records_.size();
+      records_.push_back(Record{value, 0, true});
+    } else {
+      index = free_.back();
+      free_.pop_back();
+      records_[index].value = value;
+      records_[index].active = true;
+    }
+    heap_.push(Timer{deadline, index, records_[index].generation});
+    return fdt::TimerHandle{index, records_[index].generation};
+  }
+
+  bool cancel(fdt::TimerHandle handle) {
+    Record& record = records_[handle.index];
+    if (!record.active || record.generation != handle.generation) {
+      return false;
+    }
+    release(handle.index);
+    return true;
+  }
+
+  template <class Expire>
+  size_t advance(uint64_t now, Expire expire) {
+    size_t fired = 0;
+    now_ = now;
+    while (!heap_.empty() && heap_.top().deadline <= now) {
+      Timer timer = heap_.top();
+      heap_.pop();
+      Record& record = records_[timer.index];
+      if (record.active && record.generation == timer.generation) {
+        uint64_t value = record.value;
+        release(timer.index);
+        expire(value);
+        fired++;
+      }
+    }
+    return fired;
+  }
+
+  uint64_t now() const {
+    return now_;
+  }
+
+private:
+  struct Timer {
+    uint64_t deadline;
+    uint32_t index;
+    uint32_t generation;
+
+    bool operator>(const Timer& other) const {
+      return deadline > other.deadline;
+    }
+  };
+
+  struct Record {
+    uint64_t value;
+    uint32_t generation;
+    bool active;
+  };
+
+  std::priority_queue<Timer, std::vector<Timer>, std::greater<Timer>> heap_;
+  std::vector<Record> records_;
+  std::vector<uint32_t> free_;
+  uint64_t now_ = 0;
+
+  void release(uint32_t index) {
+    records_[index].generation++;
+    records_[index].active = false;
+    free_.push_back(index);
+  }
+};
+
+template <class Timers>
+static void schedule_expire(benchmark::State& state) {
+  Timers timers;
+  Random random;
+  for (size_t i = 0; i < ACTIVE; i++) {
+    timers.schedule(1 + random.next() % HORIZON, i);
+  }
+  uint64_t sum = 0;
+  size_t i = 0;
+  for (auto _ : state) {
+    timers.schedule(timers.now() + 1 + random.next() % HORIZON, i);
+    if (++i % 32 == 0) {
+      timers.advance(timers.now() + 1, [&sum](uint64_t value) { sum += value; });
+    }
+  }
+  benchmark::DoNotOptimize(sum);
+  state.SetItemsProcessed(state.iterations());
+}
+
+template <class Timers>
+static void schedule_cancel(benchmark::State& state) {
+  Timers timers;
+  Random random;
+  std::vector<fdt::TimerHandle> handles;
+  for (size_t i = 0; i < ACTIVE; i++) {
+    handles.push_back(timers.schedule(1 + random.next() % HORIZON, i));
+  }
+  size_t i = 0;
+  for (auto _ : state) {
+    fdt::TimerHandle& handle = handles[random.next() % ACTIVE];
+    timers.cancel(handle);
+    handle = timers.schedule(timers.now() + 1 + random.next() % HORIZON, i);
+    if (++i % 32 == 0) {
+      timers.advance(timers.now() + 1, [](uint64_t) {});
+    }
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+
+static void BM_timing_wheel_schedule_expire(benchmark::State& state) {
+  schedule_expire<fdt::TimingWheel<uint64_t>>(state);
+}
+
+static void BM_priority_queue_schedule_expire(benchmark::State& state) {
+  schedule_expire<HeapTimers>(state);
+}
+
+static void BM_timing_wheel_schedule_cancel(benchmark::State& state) {
+  schedule_cancel<fdt::TimingWheel<uint64_t>>(state);
+}
+
+static void BM_priority_queue_schedule_cancel(benchmark::State& state) {
+  schedule_cancel<HeapTimers>(state);
+}
+
+BENCHMARK(BM_timing_wheel_schedule_expire);
+BENCHMARK(BM_priority_queue_schedule_expire);
+BENCHMARK(BM_timing_wheel_schedule_cancel);
+BENCHMARK(BM_priority_queue_schedule_cancel);
@@ -2,7 +2,9 @@
 
 #include <Deque.h>
 #include <LockfreeQueue.h>
+#include <ConcurrentDeque.h>
 #include <thread>
+#include <atomic>
 #include <mutex>
 #include <deque>
 #include <vector>
@@ -79,8 +81,93 @@ static void std_deque_message_send_and_receive() {
     std::cout << std::endl;
 }
 
+// Threads push distinct values at both ends while others pop from both ends;
+// every value has to come out exactly once.
+static void concurrent_deque_stress() {
+    const int THREADS = 8;
+    fdt::ConcurrentDeque<int> q(4);
+    std::vector<std::vector<int>> popped(THREADS);
+    std::vector<std::thread> threads;
+    for (int t = 0; t < THREADS; t++) {
+        threads.emplace_back([&, t]{
+            for (int i = 0; i < ITER_TIME; i++) {
+                int value = t * ITER_TIME + i;
+                if (i % 2 == 0) {
+                    q.push_back(value);
+                } else {
+                    q.push_front(value);
+                }
+                int out;
+                if ((t + i) % 2 == 0 ? q.try_pop_front(out) : q.try_pop_back(out)) {
+                    popped[t].push_back(out);
+                }
+            }
+        });
+    }
+    for (std::thread& thread : threads) {
+        thread.join();
+    }
+    int out;
+    while (q.try_pop_back(out)) {
+        popped[0].push_back(out);
+    }
 
+    std::vector<int> seen(THREADS * ITER_TIME, 0);
+    for (const std::vector<int>& values : popped) {
+        for (int value : values) {
+            seen[value]++;
+        }
+    }
+    for (int i = 0; i < THREADS * ITER_TIME; i++) {
+      if (seen[i] != 1) {
+        std::cout << i << " seen " << seen[i] << " times" << std::endl;
+        throw "concurrent deque error";
+      }
+    }
+    std::cout << "concurrent deque ok" << std::endl;
+}
 
+// Threads race to pop from both ends of a deque that is empty, or holds a
+// single element, at the time; only the pushed values may ever come out.
+static void concurrent_deque_empty_pop_race() {
+    const int THREADS = 4;
+    const int ROUNDS = 2000;
+    fdt::ConcurrentDeque<long> q(4);
+    std::atomic<int> popped(0);
+    for (int round = 0; round < ROUNDS; round++) {
+        if (round % 2 == 1) {
+            q.push_back(round);
+        }
+        std::atomic<int> ready(0);
+        std::vector<std::thread> threads;
+        for (int t = 0; t < THREADS; t++) {
+            threads.emplace_back([&, t]{
+                ready++;
+                while (ready.load() < THREADS) {
+                    std::this_thread::yield();
+                }
+                long out;
+                if (t % 2 == 0 ? q.try_pop_front(out) : q.try_pop_back(out)) {
+                    if (out != round) {
+                        throw "concurrent deque popped a value never pushed";
+                    }
+                    popped++;
+                }
+                if (q.size() > 1) {
+                    throw "concurrent deque size out of range";
+                }
+            });
+        }
+        for (std::thread& thread : threads) {
+            thread.join();
+        }
+    }
+    if (popped.load() != ROUNDS / 2 || !q.empty()) {
+        std::cout << popped.load() << " pops, size " << q.size() << std::endl;
+        throw "concurrent deque empty pop error";
+    }
+    std::cout << "concurrent deque empty pops ok" << std::endl;
+}
 
 int main() {
   Deque<int> deque;
@@ -123,6 +210,8 @@ int main() {
   std::cout << std::endl;
 
   std::cout << deque2 << std::endl;
+  concurrent_deque_stress();
+  concurrent_deque_empty_pop_race();
   for(int i = 0; i < 1000; i++) {
     deque_message_send_and_receive();
   }
@@ -0,0 +1,185 @@
+#ifndef _FDT_BYTE_RING_H_
+#define _FDT_BYTE_RING_H_
+
+#include "Span.h"
+
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <stdexcept>
+#include <string>
+
+namespace fdt {
+// Single-producer single-consumer ring of variable-length byte records. The
+// producer reserves room for a record, serializes straight into the ring and
+// commits it; the consumer peeks at the next record in place and releases it
+// when done. Nothing is allocated or copied per record.
+//
+// Each record is an 8-byte header holding its length followed by the payload,
+// padded to a multiple of 8 so that every header and payload is 8-byte
+// aligned. A record never wraps: when it does not fit before the end of the
+// buffer, a header with length WRAP tells the consumer to continue at the
+// start. A record may take at most half the capacity, which guarantees that
+// it fits once the consumer has caught up, wherever the ring currently ends.
+// The capacity is rounded up to a multiple of 16 so that half of it is still
+// a whole number of 8-byte units.
+class ByteRing {
+public:
+  explicit ByteRing(size_t capacity);
+  ByteRing(const ByteRing&) = delete;
+  ByteRing& operator=(const ByteRing&) = delete;
+
+  // Producer side. reserve_write returns false while the ring is too full;
+  // at most one reservation is open at a time. commit_write may publish
+  // fewer bytes than were reserved, down to an empty record.
+  bool reserve_write(size_t length, Span<char>& out);
+  void commit_write();
+  void commit_write(size_t length);
+
+  // Consumer side. peek_read returns false when there is no record; an empty
+  // record comes back as true with an empty span. The span stays valid until
+  // release_read.
+  bool peek_read(Span<const char>& in);
+  void release_read();
+
+  size_t capacity() const;
+  size_t max_record_size() const;
+  bool empty() const;
+
+  static const uint32_t WRAP = 0xFFFFFFFF;
+  static const size_t HEADER_SIZE = 8;
+
+private:
+  struct alignas(64) Producer {
+    std::atomic<uint64_t> write;
+    uint64_t cached_read;
+    uint64_t reserved_at;
+    size_t reserved;
+  };
+
+  struct alignas(64) Consumer {
+    std::atomic<uint64_t> read;
+    uint64_t cached_write;
+    size_t peeked;
+  };
+
+  std::unique_ptr<uint64_t[]> storage_;
+  char* buffer_;
+  size_t capacity_;
+  Producer producer_;
+  Consumer consumer_;
+
+  static size_t record_size(size_t length);
+  void write_header(uint64_t position, uint32_t length);
+  uint32_t read_header(uint64_t position) const;
+};
+
+inline ByteRing::ByteRing(size_t capacity)
+    : capacity_((capacity + 2 * HEADER_SIZE - 1) / (2 * HEADER_SIZE) * (2 * HEADER_SIZE)) {
+  if (capacity_ == 0) {
+    capacity_ = 2 * HEADER_SIZE;
+  }
+  storage_.reset(new uint64_t[capacity_ / sizeof(uint64_t)]);
+  buffer_ = reinterpret_cast<char*>(storage_.get());
+  producer_.write.store(0, std::memory_order_relaxed);
+  producer_.cached_read = 0;
+  producer_.reserved_at = 0;
+  producer_.reserved = 0;
+  consumer_.read.store(0, std::memory_order_relaxed);
+  consumer_.cached_write = 0;
+  consumer_.peeked = 0;
+}
+
+inline bool ByteRing::reserve_write(size_t length, Span<char>& out) {
+  if (length > max_record_size()) {
+    throw std::length_error("ByteRing: record of " + std::to_string(length)
+        + " bytes exceeds the maximum of " + std::to_string(max_record_size()));
+  }
+  uint64_t write = producer_.write.load(std::memory_order_relaxed);
+  size_t offset = write % capacity_;
+  size_t size = record_size(length);
+  size_t skip = capacity_ - offset < size ? capacity_ - offset : 0;
+  if (write + skip + size - producer_.cached_read > capacity_) {
+    producer_.cached_read = consumer_.read.load(std::memory_order_acquire);
+    if (write + skip + size - producer_.cached_read > capacity_) {
+      return false;
+    }
+  }
+  if (skip > 0) {
+    write_header(write, WRAP);
+  }
+  producer_.reserved_at = write + skip;
+  producer_.reserved = length;
+  out = Span<char>(buffer_ + (producer_.reserved_at % capacity_) + HEADER_SIZE, length);
+  return true;
+}
+
+inline void ByteRing::commit_write() {
+  commit_write(producer_.reserved);
+}
+
+inline void ByteRing::commit_write(size_t length) {
+  if (length > producer_.reserved) {
+    throw std::length_error("ByteRing: commit of " + std::to_string(length)
+        + " bytes exceeds the reservation of " + std::to_string(producer_.reserved));
+  }
+  write_header(producer_.reserved_at, (uint32_t) length);
+  producer_.write.store(producer_.reserved_at + record_size(length), std::memory_order_release);
+  producer_.reserved = 0;
+}
+
+inline bool ByteRing::peek_read(Span<const char>& in) {
+  uint64_t read = consumer_.read.load(std::memory_order_relaxed);
+  if (read == consumer_.cached_write) {
+    consumer_.cached_write = producer_.write.load(std::memory_order_acquire);
+    if (read == consumer_.cached_write) {
+      return false;
+    }
+  }
+  uint32_t length = read_header(read);
+  if (length == WRAP) {
+    // The wrap marker and the record after it were published together.
+    read += capacity_ - read % capacity_;
+    consumer_.read.store(read, std::memory_order_release);
+    length = read_header(read);
+  }
+  consumer_.peeked = record_size(length);
+  in = Span<const char>(buffer_ + (read % capacity_) + HEADER_SIZE, length);
+  return true;
+}
+
+inline void ByteRing::release_read() {
+  uint64_t read = consumer_.read.load(std::memory_order_relaxed);
+  consumer_.read.store(read + consumer_.peeked, std::memory_order_release);
+  consumer_.peeked = 0;
+}
+
+inline size_t ByteRing::capacity() const {
+  return capacity_;
+}
+
+inline size_t ByteRing::max_record_size() const {
+  return capacity_ / 2 - HEADER_SIZE;
+}
+
+inline bool ByteRing::empty() const {
+  return consumer_.read.load(std::memory_order_acquire)
+    == producer_.write.load(std::memory_order_acquire);
+}
+
+inline size_t ByteRing::record_size(size_t length) {
+  return HEADER_SIZE + (length + HEADER_SIZE - 1) / HEADER_SIZE * HEADER_SIZE;
+}
+
+inline void ByteRing::write_header(uint64_t position, uint32_t length) {
+  std::memcpy(buffer_ + position % capacity_, &length, sizeof(length));
+}
+
+inline uint32_t ByteRing::read_header(uint64_t position) const {
+  uint32_t length;
+  std::memcpy(&length, buffer_ + position % capacity_, sizeof(length));
+  return length;
+}
+}
+#endif
@@ -0,0 +1,217 @@
+#ifndef _FDT_CHANNEL_H_
+#define _FDT_CHANNEL_H_
+
+#include "LockfreeQueue.h"
+
+#include <atomic>
+#include <coroutine>
+#include <utility>
+
+namespace fdt {
+// Single-producer single-consumer channel for C++20 coroutines on top of
+// LockfreeQueue. `co_await channel.pop()` suspends while the ring is empty and
+// `co_await channel.push(v)` while it is full; the other side resumes the
+// suspended coroutine inline from its own push or pop. When the ring is
+// neither empty nor full no coroutine is suspended and the only shared
+// writes are the queue's own atomics.
+//
+// A suspending side publishes its handle and then re-checks the ring; the
+// other side changes the ring and then checks for a handle. Both are
+// sequentially consistent, so at least one of them sees the other and a
+// wakeup cannot be lost. Resumption happens on the thread that made progress
+// possible.
+template <typename T, class Allocator = std::allocator<T>>
+class Channel {
+public:
+  class PushAwaiter;
+  class PopAwaiter;
+
+  Channel();
+  explicit Channel(size_t capacity, const Allocator& alloca = Allocator());
+  Channel(const Channel&) = delete;
+  Channel& operator=(const Channel&) = delete;
+
+  PushAwaiter push(T value);
+  PopAwaiter pop();
+  bool try_push(T value);
+  bool try_pop(T& value);
+
+  size_t capacity() const;
+  size_t size() const;
+  bool empty() const;
+  bool full() const;
+
+private:
+  LockfreeQueue<T, Allocator> queue_;
+  std::atomic<void*> consumer_waiter_;
+  std::atomic<void*> producer_waiter_;
+
+  static const size_t DEFAULT_CAPACITY = 64;
+
+  bool has_space() const;
+  bool has_value() const;
+  void enqueue(T& value);
+  T dequeue();
+  static bool wait(std::atomic<void*>& waiter, std::coroutine_handle<> handle,
+      bool (Channel::*ready)() const, const Channel* channel);
+  static void wake(std::atomic<void*>& waiter);
+};
+
+template <typename T, class Allocator>
+class Channel<T, Allocator>::PushAwaiter {
+public:
+  bool await_ready() {
+    pushed_ = channel_->try_push(value_);
+    return pushed_;
+  }
+
+  bool await_suspend(std::coroutine_handle<> handle) {
+    return wait(channel_->producer_waiter_, handle, &Channel::has_space, channel_);
+  }
+
+  void await_resume() {
+    if (!pushed_) {
+      channel_->enqueue(value_);
+    }
+  }
+
+private:
+  Channel* channel_;
+  T value_;
+  bool pushed_;
+
+  PushAwaiter(Channel* channel, T value)
+      : channel_(channel), value_(std::move(value)), pushed_(false) {}
+
+  friend class Channel;
+};
+
+template <typename T, class Allocator>
+class Channel<T, Allocator>::PopAwaiter {
+public:
+  bool await_ready() {
+    return !channel_->queue_.empty();
+  }
+
+  bool await_suspend(std::coroutine_handle<> handle) {
+    return wait(channel_->consumer_waiter_, handle, &Channel::has_value, channel_);
+  }
+
+  T await_resume() {
+    return channel_->dequeue();
+  }
+
+private:
+  Channel* channel_;
+
+  explicit PopAwaiter(Channel* channel) : channel_(channel) {}
+
+  friend class Channel;
+};
+
+template <typename T, class Allocator>
+Channel<T, Allocator>::Channel() : Channel(DEFAULT_CAPACITY) {}
+
+template <typename T, class Allocator>
+Channel<T, Allocator>::Channel(size_t capacity, const Allocator& alloca)
+    : queue_(capacity, alloca), consumer_waiter_(nullptr), producer_waiter_(nullptr) {}
+
+template <typename T, class Allocator>
+typename Channel<T, Allocator>::PushAwaiter Channel<T, Allocator>::push(T value) {
+  return PushAwaiter(this, std::move(value));
+}
+
+template <typename T, class Allocator>
+typename Channel<T, Allocator>::PopAwaiter Channel<T, Allocator>::pop() {
+  return PopAwaiter(this);
+}
+
+template <typename T, class Allocator>
+bool Channel<T, Allocator>::try_push(T value) {
+  if (queue_.full()) {
+    return false;
+  }
+  enqueue(value);
+  return true;
+}
+
+template <typename T, class Allocator>
+bool Channel<T, Allocator>::try_pop(T& value) {
+  if (queue_.empty()) {
+    return false;
+  }
+  value = dequeue();
+  return true;
+}
+
+template <typename T, class Allocator>
+size_t Channel<T, Allocator>::capacity() const {
+  return queue_.capacity();
+}
+
+template <typename T, class Allocator>
+size_t Channel<T, Allocator>::size() const {
+  return queue_.size();
+}
+
+template <typename T, class Allocator>
+bool Channel<T, Allocator>::empty() const {
+  return queue_.empty();
+}
+
+template <typename T, class Allocator>
+bool Channel<T, Allocator>::full() const {
+  return queue_.full();
+}
+
+template <typename T, class Allocator>
+bool Channel<T, Allocator>::has_space() const {
+  return !queue_.full();
+}
+
+template <typename T, class Allocator>
+bool Channel<T, Allocator>::has_value() const {
+  return !queue_.empty();
+}
+
+template <typename T, class Allocator>
+void Channel<T, Allocator>::enqueue(T& value) {
+  queue_.push_back(std::move(value));
+  wake(consumer_waiter_);
+}
+
+template <typename T, class Allocator>
+T Channel<T, Allocator>::dequeue() {
+  T value = std::move(queue_.front());
+  queue_.pop_front();
+  wake(producer_waiter_);
+  return value;
+}
+
+template <typename T, class Allocator>
+bool Channel<T, Allocator>::wait(std::atomic<void*>& waiter,
+    std::coroutine_handle<> handle, bool (Channel::*ready)() const,
+    const Channel* channel) {
+  void* address = handle.address();
+  waiter.store(address);
+  if (!(channel->*ready)()) {
+    return true;
+  }
+  // The ring changed before the handle was seen. Take the handle back unless
+  // the other side already claimed it, in which case it owns the resumption
+  // and the awaiter must not be touched any more.
+  return !waiter.compare_exchange_strong(address, nullptr);
+}
+
+template <typename T, class Allocator>
+void Channel<T, Allocator>::wake(std::atomic<void*>& waiter) {
+  if (waiter.load() == nullptr) {
+    return;
+  }
+  void* address = waiter.exchange(nullptr);
+  if (address != nullptr) {
+    std::coroutine_handle<>::from_address(address).resume();
+  }
+}
+}
+#endif
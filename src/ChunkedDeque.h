@@ -0,0 +1,579 @@
+#ifndef _FDT_CHUNKED_DEQUE_H_
+#define _FDT_CHUNKED_DEQUE_H_
+#include "ChunkedDequeIterator.h"
+#include "Stats.h"
+
+#include <string>
+#include <ostream>
+#include <sstream>
+#include <initializer_list>
+#include <stdexcept>
+#include <memory>
+#include <iterator>
+#include <algorithm>
+#include <type_traits>
+#include <vector>
+
+namespace fdt {
+// Deque made of fixed-size blocks referenced from a circular block map, with
+// the same interface as Deque. Pushing at either end never moves existing
+// elements, so references stay valid until the element is popped, and
+// growing costs at most one block allocation plus, rarely, a copy of the
+// block map. Blocks freed by pops are kept in a pool and reused.
+template <typename T,
+    size_t BlockSize = (sizeof(T) < 4096 ? 4096 / sizeof(T) : 1),
+    class Allocator = std::allocator<T>, class Stats = NoStats>
+class ChunkedDeque : private Stats {
+public:
+  typedef ChunkedDequeIterator<T, BlockSize> iterator;
+
+  ChunkedDeque();
+  ChunkedDeque(size_t capacity, const Allocator& alloca = Allocator());
+  ChunkedDeque(const ChunkedDeque& deque, const Allocator& alloca = Allocator());
+  ChunkedDeque(std::initializer_list<T> container, const Allocator& alloca = Allocator());
+  ~ChunkedDeque();
+  ChunkedDeque& operator=(const ChunkedDeque& deque);
+  ChunkedDeque& operator=(std::initializer_list<T> container);
+
+  void push_front(T value);
+  void push_back(T value);
+  void pop_front();
+  void pop_back();
+  void erase(const iterator& begin, const iterator& end);
+  void erase(const iterator& it);
+  void insert(const iterator& it, T value);
+  void insert(const iterator& it, size_t count, const T& value);
+  template <typename ForwardIt,
+      typename = typename std::enable_if<!std::is_integral<ForwardIt>::value>::type>
+  void insert(const iterator& it, ForwardIt first, ForwardIt last);
+  void reserve(size_t);
+  void resize(size_t, T = T());
+  void clear();
+  void shrink_to_fit();
+
+  T& front();
+  T& back();
+  T& at(size_t index);
+  T& operator[](size_t index);
+  T front() const;
+  T back() const;
+  T at(size_t index) const;
+  T operator[](size_t index) const;
+
+  iterator begin() const;
+  iterator end() const;
+
+  size_t capacity() const;
+  size_t size() const;
+  bool empty() const;
+  std::string to_string() const;
+  StatsSnapshot stats() const;
+
+private:
+  typedef typename std::allocator_traits<Allocator>::template rebind_alloc<T*> MapAllocator;
+
+  T** map_;
+  size_t map_capacity_;
+  size_t map_head_;
+  size_t blocks_;
+  std::vector<T*> pool_;
+  Allocator alloca_;
+  MapAllocator map_alloca_;
+  size_t front_;
+  size_t size_;
+
+  static const size_t DEFAULT_MAP_CAPACITY = 8;
+
+  T& element(size_t position) const;
+  T*& block(size_t index) const;
+  T* acquire_block();
+  void release_block(T* block);
+  void free_block(T* block);
+  void reserve_map(size_t blocks);
+  void add_block_front();
+  void add_block_back();
+  void grow_front(size_t count);
+  void grow_back(size_t count);
+  void drop_front(size_t count);
+  void drop_back(size_t count);
+  void release_all();
+  size_t open_gap(size_t index, size_t count);
+  void out_of_range(const char*, size_t, const char*, const char*, size_t) const;
+  void check_nonempty() const;
+};
+
+template <typename T, size_t BlockSize, class Allocator, class Stats>
+ChunkedDeque<T, BlockSize, Allocator, Stats>::ChunkedDeque() : ChunkedDeque(0) {}
+
+template <typename T, size_t BlockSize, class Allocator, class Stats>
+ChunkedDeque<T, BlockSize, Allocator, Stats>::ChunkedDeque(size_t capacity,
+    const Allocator& alloca)
+    : map_(nullptr), map_capacity_(0), map_head_(0), blocks_(0), alloca_(alloca),
+      map_alloca_(alloca), front_(0), size_(0) {
+  reserve_map(DEFAULT_MAP_CAPACITY);
+  reserve(capacity);
+}
+
+template <typename T, size_t BlockSize, class Allocator, class Stats>
+ChunkedDeque<T, BlockSize, Allocator, Stats>::ChunkedDeque(const ChunkedDeque& deque,
+    const Allocator& alloca)
+    : ChunkedDeque(deque.size_, alloca) {
+  for (size_t i = 0; i < deque.size_; i++) {
+    push_back(deque[i]);
+  }
+}
+
+template <typename T, size_t BlockSize, class Allocator, class Stats>
+ChunkedDeque<T, BlockSize, Allocator, Stats>::ChunkedDeque(std::initializer_list<T> container,
+    const Allocator& alloca)
+    : ChunkedDeque(container.size(), alloca) {
+  for (const T& value : container) {
+    push_back(value);
+  }
+}
+
+template <typename T, size_t BlockSize, class Allocator, class Stats>
+ChunkedDeque<T, BlockSize, Allocator, Stats>::~ChunkedDeque() {
+  release_all();
+  shrink_to_fit();
+  map_alloca_.deallocate(map_, map_capacity_);
+}
+
+template <typename T, size_t BlockSize, class Allocator, class Stats>
+ChunkedDeque<T, BlockSize, Allocator, Stats>&
+ChunkedDeque<T, BlockSize, Allocator, Stats>::operator=(const ChunkedDeque& deque) {
+  if (this == &deque) {
+    return *this;
+  }
+  clear();
+  reserve(deque.size_);
+  for (size_t i = 0; i < deque.size_; i++) {
+    push_back(deque[i]);
+  }
+  return *this;
+}
+
+template <typename T, size_t BlockSize, class Allocator, class Stats>
+ChunkedDeque<T, BlockSize, Allocator, Stats>&
+ChunkedDeque<T, BlockSize, Allocator, Stats>::operator=(std::initializer_list<T> container) {
+  clear();
+  reserve(container.size());
+  for (const T& value : container) {
+    push_back(value);
+  }
+  return *this;
+}
+
+template <typename T, size_t BlockSize, class Allocator, class Stats>
+void ChunkedDeque<T, BlockSize, Allocator, Stats>::push_front(T value) {
+  if (front_ == 0) {
+    add_block_front();
+    front_ = BlockSize;
+  }
+  front_--;
+  element(front_) = value;
+  size_++;
+  Stats::on_push(size_);
+}
+
+template <typename T, size_t BlockSize, class Allocator, class Stats>
+void ChunkedDeque<T, BlockSize, Allocator, Stats>::push_back(T value) {
+  if (front_ + size_ == blocks_ * BlockSize) {
+    add_block_back();
+  }
+  element(front_ + size_) = value;
+  size_++;
+  Stats::on_push(size_);
+}
+
+template <typename T, size_t BlockSize, class Allocator, class Stats>
+void ChunkedDeque<T, BlockSize, Allocator, Stats>::pop_front() {
+  check_nonempty();
+  drop_front(1);
+}
+
+template <typename T, size_t BlockSize, class Allocator, class Stats>
+void ChunkedDeque<T, BlockSize, Allocator, Stats>::pop_back() {
+  check_nonempty();
+  drop_back(1);
+}
+
+template <typename T, size_t BlockSize, class Allocator, class Stats>
+void ChunkedDeque<T, BlockSize, Allocator, Stats>::erase(const iterator& begin,
+    const iterator& end) {
+  if (begin.index_ >= size_) {
+    out_of_range("begin.index_", begin.index_, ">=", "this->size()", size_);
+  }
+  if (end.index_ > size_) {
+    out_of_range("end.index_", end.index_, ">", "this->size()", size_);
+  }
+  if (begin.index_ > end.index_) {
+    out_of_range("begin.index_", begin.index_, ">", "end.index_", end.index_);
+  }
+  size_t offset = end.index_ - begin.index_;
+  if (offset == 0) {
+    return;
+  }
+  if (begin.index_ + end.index_ < size_) {
+    Stats::on_shift(begin.index_ * sizeof(T));
+    for (size_t i = begin.index_; i > 0; i--) {
+      (*this)[i - 1 + offset] = (*this)[i - 1];
+    }
+    drop_front(offset);
+  }
+  else {
+    Stats::on_shift((size_ - end.index_) * sizeof(T));
+    for (size_t i = end.index_; i < size_; i++) {
+      (*this)[i - offset] = (*this)[i];
+    }
+    drop_back(offset);
+  }
+}
+
+template <typename T, size_t BlockSize, class Allocator, class Stats>
+void ChunkedDeque<T, BlockSize, Allocator, Stats>::erase(const iterator& it) {
+  return erase(it, it + 1);
+}
+
+template <typename T, size_t BlockSize, class Allocator, class Stats>
+void ChunkedDeque<T, BlockSize, Allocator, Stats>::insert(const iterator& it, T value) {
+  insert(it, 1, value);
+}
+
+template <typename T, size_t BlockSize, class Allocator, class Stats>
+void ChunkedDeque<T, BlockSize, Allocator, Stats>::insert(const iterator& it, size_t count,
+    const T& value) {
+  size_t index = open_gap(it.index_, count);
+  for (size_t i = 0; i < count; i++) {
+    (*this)[index + i] = value;
+  }
+}
+
+template <typename T, size_t BlockSize, class Allocator, class Stats>
+template <typename ForwardIt, typename>
+void ChunkedDeque<T, BlockSize, Allocator, Stats>::insert(const iterator& it,
+    ForwardIt first, ForwardIt last) {
+  size_t index = open_gap(it.index_, std::distance(first, last));
+  for (; first != last; ++first) {
+    (*this)[index++] = *first;
+  }
+}
+
+template <typename T, size_t BlockSize, class Allocator, class Stats>
+void ChunkedDeque<T, BlockSize, Allocator, Stats>::reserve(size_t capacity) {
+  // One extra block because the front element may sit anywhere in its block.
+  size_t blocks = (capacity + BlockSize - 1) / BlockSize + 1;
+  reserve_map(blocks);
+  while (blocks_ + pool_.size() < blocks) {
+    T* block = alloca_.allocate(BlockSize);
+    if (!std::is_trivial<T>::value) {
+      std::uninitialized_fill_n(block, BlockSize, T());
+    }
+    pool_.push_back(block);
+  }
+}
+
+template <typename T, size_t BlockSize, class Allocator, class Stats>
+void ChunkedDeque<T, BlockSize, Allocator, Stats>::resize(size_t size, T value) {
+  if (size < size_) {
+    drop_back(size_ - size);
+    return;
+  }
+  size_t old_size = size_;
+  grow_back(size - size_);
+  for (size_t i = old_size; i < size_; i++) {
+    (*this)[i] = value;
+  }
+  Stats::on_push(size_);
+}
+
+template <typename T, size_t BlockSize, class Allocator, class Stats>
+void ChunkedDeque<T, BlockSize, Allocator, Stats>::clear() {
+  release_all();
+}
+
+template <typename T, size_t BlockSize, class Allocator, class Stats>
+void ChunkedDeque<T, BlockSize, Allocator, Stats>::shrink_to_fit() {
+  for (T* block : pool_) {
+    free_block(block);
+  }
+  pool_.clear();
+}
+
+template <typename T, size_t BlockSize, class Allocator, class Stats>
+T& ChunkedDeque<T, BlockSize, Allocator, Stats>::front() {
+  check_nonempty();
+  return element(front_);
+}
+
+template <typename T, size_t BlockSize, class Allocator, class Stats>
+T& ChunkedDeque<T, BlockSize, Allocator, Stats>::back() {
+  check_nonempty();
+  return element(front_ + size_ - 1);
+}
+
+template <typename T, size_t BlockSize, class Allocator, class Stats>
+T& ChunkedDeque<T, BlockSize, Allocator, Stats>::at(size_t index) {
+  if (index >= size_) {
+    out_of_range("index", index, ">=", "this->size()", size_);
+  }
+  return operator[](index);
+}
+
+template <typename T, size_t BlockSize, class Allocator, class Stats>
+T& ChunkedDeque<T, BlockSize, Allocator, Stats>::operator[](size_t index) {
+  return element(front_ + index);
+}
+
+template <typename T, size_t BlockSize, class Allocator, class Stats>
+T ChunkedDeque<T, BlockSize, Allocator, Stats>::front() const {
+  check_nonempty();
+  return element(front_);
+}
+
+template <typename T, size_t BlockSize, class Allocator, class Stats>
+T ChunkedDeque<T, BlockSize, Allocator, Stats>::back() const {
+  check_nonempty();
+  return element(front_ + size_ - 1);
+}
+
+template <typename T, size_t BlockSize, class Allocator, class Stats>
+T ChunkedDeque<T, BlockSize, Allocator, Stats>::at(size_t index) const {
+  if (index >= size_) {
+    out_of_range("index", index, ">=", "this->size()", size_);
+  }
+  return element(front_ + index);
+}
+
+template <typename T, size_t BlockSize, class Allocator, class Stats>
+T ChunkedDeque<T, BlockSize, Allocator, Stats>::operator[](size_t index) const {
+  return element(front_ + index);
+}
+
+template <typename T, size_t BlockSize, class Allocator, class Stats>
+typename ChunkedDeque<T, BlockSize, Allocator, Stats>::iterator
+ChunkedDeque<T, BlockSize, Allocator, Stats>::begin() const {
+  return iterator(map_, map_capacity_, map_head_, size_, front_, 0);
+}
+
+template <typename T, size_t BlockSize, class Allocator, class Stats>
+typename ChunkedDeque<T, BlockSize, Allocator, Stats>::iterator
+ChunkedDeque<T, BlockSize, Allocator, Stats>::end() const {
+  return iterator(map_, map_capacity_, map_head_, size_, front_, size_);
+}
+
+template <typename T, size_t BlockSize, class Allocator, class Stats>
+size_t ChunkedDeque<T, BlockSize, Allocator, Stats>::capacity() const {
+  return (blocks_ + pool_.size()) * BlockSize;
+}
+
+template <typename T, size_t BlockSize, class Allocator, class Stats>
+size_t ChunkedDeque<T, BlockSize, Allocator, Stats>::size() const {
+  return size_;
+}
+
+template <typename T, size_t BlockSize, class Allocator, class Stats>
+bool ChunkedDeque<T, BlockSize, Allocator, Stats>::empty() const {
+  return size_ == 0;
+}
+
+template <typename T, size_t BlockSize, class Allocator, class Stats>
+std::string ChunkedDeque<T, BlockSize, Allocator, Stats>::to_string() const {
+  std::ostringstream out;
+  out << "[ ";
+  for (size_t i = 0; i < size_; i++) {
+    out << (*this)[i] << " ";
+  }
+  out << "]";
+  return out.str();
+}
+
+template <typename T, size_t BlockSize, class Allocator, class Stats>
+StatsSnapshot ChunkedDeque<T, BlockSize, Allocator, Stats>::stats() const {
+  return Stats::snapshot();
+}
+
+template <typename T, size_t BlockSize, class Allocator, class Stats>
+std::ostream& operator<<(std::ostream& out,
+    const ChunkedDeque<T, BlockSize, Allocator, Stats>& deque) {
+  return out << deque.to_string();
+}
+
+template <typename T, size_t BlockSize, class Allocator, class Stats>
+inline T& ChunkedDeque<T, BlockSize, Allocator, Stats>::element(size_t position) const {
+  return block(position / BlockSize)[position % BlockSize];
+}
+
+template <typename T, size_t BlockSize, class Allocator, class Stats>
+inline T*& ChunkedDeque<T, BlockSize, Allocator, Stats>::block(size_t index) const {
+  return map_[(map_head_ + index) % map_capacity_];
+}
+
+template <typename T, size_t BlockSize, class Allocator, class Stats>
+T* ChunkedDeque<T, BlockSize, Allocator, Stats>::acquire_block() {
+  if (pool_.empty()) {
+    reserve((blocks_ + 1) * BlockSize);
+  }
+  T* block = pool_.back();
+  pool_.pop_back();
+  return block;
+}
+
+template <typename T, size_t BlockSize, class Allocator, class Stats>
+void ChunkedDeque<T, BlockSize, Allocator, Stats>::release_block(T* block) {
+  pool_.push_back(block);
+}
+
+template <typename T, size_t BlockSize, class Allocator, class Stats>
+void ChunkedDeque<T, BlockSize, Allocator, Stats>::free_block(T* block) {
+  if (!std::is_trivial<T>::value) {
+    for (size_t i = 0; i < BlockSize; i++) {
+      block[i].~T();
+    }
+  }
+  alloca_.deallocate(block, BlockSize);
+}
+
+// Grows the block map, copying only block pointers, so that it can hold at
+// least `blocks` blocks.
+template <typename T, size_t BlockSize, class Allocator, class Stats>
+void ChunkedDeque<T, BlockSize, Allocator, Stats>::reserve_map(size_t blocks) {
+  if (blocks <= map_capacity_) {
+    return;
+  }
+  size_t capacity = std::max(blocks, map_capacity_ * 2);
+  T** map = map_alloca_.allocate(capacity);
+  for (size_t i = 0; i < blocks_; i++) {
+    map[i] = block(i);
+  }
+  if (map_ != nullptr) {
+    Stats::on_reallocate();
+    Stats::on_reserve(blocks_ * sizeof(T*));
+    map_alloca_.deallocate(map_, map_capacity_);
+  }
+  map_ = map;
+  map_capacity_ = capacity;
+  map_head_ = 0;
+}
+
+template <typename T, size_t BlockSize, class Allocator, class Stats>
+void ChunkedDeque<T, BlockSize, Allocator, Stats>::add_block_front() {
+  T* block = acquire_block();
+  reserve_map(blocks_ + 1);
+  map_head_ = (map_head_ + map_capacity_ - 1) % map_capacity_;
+  map_[map_head_] = block;
+  blocks_++;
+}
+
+template <typename T, size_t BlockSize, class Allocator, class Stats>
+void ChunkedDeque<T, BlockSize, Allocator, Stats>::add_block_back() {
+  T* block = acquire_block();
+  reserve_map(blocks_ + 1);
+  this->block(blocks_) = block;
+  blocks_++;
+}
+
+template <typename T, size_t BlockSize, class Allocator, class Stats>
+void ChunkedDeque<T, BlockSize, Allocator, Stats>::grow_front(size_t count) {
+  while (front_ < count) {
+    add_block_front();
+    front_ += BlockSize;
+  }
+  front_ -= count;
+  size_ += count;
+}
+
+template <typename T, size_t BlockSize, class Allocator, class Stats>
+void ChunkedDeque<T, BlockSize, Allocator, Stats>::grow_back(size_t count) {
+  while (front_ + size_ + count > blocks_ * BlockSize) {
+    add_block_back();
+  }
+  size_ += count;
+}
+
+template <typename T, size_t BlockSize, class Allocator, class Stats>
+void ChunkedDeque<T, BlockSize, Allocator, Stats>::drop_front(size_t count) {
+  size_ -= count;
+  if (size_ == 0) {
+    release_all();
+    return;
+  }
+  front_ += count;
+  while (front_ >= BlockSize) {
+    release_block(block(0));
+    map_head_ = (map_head_ + 1) % map_capacity_;
+    blocks_--;
+    front_ -= BlockSize;
+  }
+}
+
+template <typename T, size_t BlockSize, class Allocator, class Stats>
+void ChunkedDeque<T, BlockSize, Allocator, Stats>::drop_back(size_t count) {
+  size_ -= count;
+  if (size_ == 0) {
+    release_all();
+    return;
+  }
+  while (front_ + size_ <= (blocks_ - 1) * BlockSize) {
+    release_block(block(blocks_ - 1));
+    blocks_--;
+  }
+}
+
+template <typename T, size_t BlockSize, class Allocator, class Stats>
+void ChunkedDeque<T, BlockSize, Allocator, Stats>::release_all() {
+  for (size_t i = 0; i < blocks_; i++) {
+    release_block(block(i));
+  }
+  blocks_ = 0;
+  map_head_ = 0;
+  front_ = 0;
+  size_ = 0;
+}
+
+// Makes room for count elements before index by growing whichever end is
+// closer and moving the elements in between, and returns index.
+template <typename T, size_t BlockSize, class Allocator, class Stats>
+size_t ChunkedDeque<T, BlockSize, Allocator, Stats>::open_gap(size_t index, size_t count) {
+  if (index > size_) {
+    out_of_range("it.index_", index, ">", "this->size()", size_);
+  }
+  if (count == 0) {
+    return index;
+  }
+  if (index < size_ - index) {
+    grow_front(count);
+    Stats::on_shift(index * sizeof(T));
+    for (size_t i = 0; i < index; i++) {
+      (*this)[i] = (*this)[i + count];
+    }
+  }
+  else {
+    size_t old_size = size_;
+    grow_back(count);
+    Stats::on_shift((old_size - index) * sizeof(T));
+    for (size_t i = old_size; i > index; i--) {
+      (*this)[i - 1 + count] = (*this)[i - 1];
+    }
+  }
+  Stats::on_push(size_);
+  return index;
+}
+
+template <typename T, size_t BlockSize, class Allocator, class Stats>
+void ChunkedDeque<T, BlockSize, Allocator, Stats>::out_of_range(const char* id_1,
+    size_t value_1, const char* op, const char* id_2, size_t value_2) const {
+  std::ostringstream out;
+  out << "ChunkedDeque: " << id_1 << " (which is " << value_1 << ") "
+    << op << " " << id_2 << " (which is " << value_2 << ")";
+  throw std::out_of_range(out.str());
+}
+
+template <typename T, size_t BlockSize, class Allocator, class Stats>
+void ChunkedDeque<T, BlockSize, Allocator, Stats>::check_nonempty() const {
+  if (size_ == 0) {
+    throw std::out_of_range("ChunkedDeque: cannot access element in empty deque");
+  }
+}
+}
+#endif
@@ -0,0 +1,195 @@
+#ifndef _FDT_CHUNKED_DEQUE_ITERATOR_H_
+#define _FDT_CHUNKED_DEQUE_ITERATOR_H_
+
+#include <cstddef>
+
+namespace fdt {
+template <typename T, size_t BlockSize>
+class ChunkedDequeIterator {
+public:
+  ChunkedDequeIterator(T* const* map, size_t map_capacity, size_t map_head,
+      size_t size, size_t front, size_t index);
+  ChunkedDequeIterator(const ChunkedDequeIterator& it);
+  ChunkedDequeIterator& operator=(const ChunkedDequeIterator& it);
+
+  T& operator*();
+  T& operator[](int);
+  T operator*() const;
+  T operator[](int) const;
+  ChunkedDequeIterator& operator++();
+  ChunkedDequeIterator& operator--();
+  ChunkedDequeIterator operator++(int);
+  ChunkedDequeIterator operator--(int);
+  ChunkedDequeIterator& operator+=(int);
+  ChunkedDequeIterator& operator-=(int);
+  ChunkedDequeIterator operator+(int offset) const;
+  ChunkedDequeIterator operator-(int offset) const;
+  int operator-(const ChunkedDequeIterator& it) const;
+  bool operator==(const ChunkedDequeIterator& it) const;
+  bool operator!=(const ChunkedDequeIterator& it) const;
+  bool operator<=(const ChunkedDequeIterator& it) const;
+  bool operator>=(const ChunkedDequeIterator& it) const;
+  bool operator<(const ChunkedDequeIterator& it) const;
+  bool operator>(const ChunkedDequeIterator& it) const;
+
+private:
+  T* const* map_;
+  size_t map_capacity_;
+  size_t map_head_;
+  size_t size_;
+  size_t front_;
+  size_t index_;
+
+  T& element(size_t index) const;
+  bool same_container(const ChunkedDequeIterator& it) const;
+
+  template <typename, size_t, class, class> friend class ChunkedDeque;
+};
+
+template <typename T, size_t BlockSize>
+ChunkedDequeIterator<T, BlockSize>::ChunkedDequeIterator(T* const* map,
+    size_t map_capacity, size_t map_head, size_t size, size_t front, size_t index)
+    : map_(map), map_capacity_(map_capacity), map_head_(map_head), size_(size),
+      front_(front), index_(index) {}
+
+template <typename T, size_t BlockSize>
+ChunkedDequeIterator<T, BlockSize>::ChunkedDequeIterator(const ChunkedDequeIterator& it)
+    : ChunkedDequeIterator(it.map_, it.map_capacity_, it.map_head_, it.size_,
+        it.front_, it.index_) {}
+
+template <typename T, size_t BlockSize>
+ChunkedDequeIterator<T, BlockSize>& ChunkedDequeIterator<T, BlockSize>::operator=(
+    const ChunkedDequeIterator& it) {
+  map_ = it.map_;
+  map_capacity_ = it.map_capacity_;
+  map_head_ = it.map_head_;
+  size_ = it.size_;
+  front_ = it.front_;
+  index_ = it.index_;
+  return *this;
+}
+
+template <typename T, size_t BlockSize>
+T& ChunkedDequeIterator<T, BlockSize>::operator*() {
+  return element(index_);
+}
+
+template <typename T, size_t BlockSize>
+T& ChunkedDequeIterator<T, BlockSize>::operator[](int offset) {
+  return element(index_ + offset);
+}
+
+template <typename T, size_t BlockSize>
+T ChunkedDequeIterator<T, BlockSize>::operator*() const {
+  return element(index_);
+}
+
+template <typename T, size_t BlockSize>
+T ChunkedDequeIterator<T, BlockSize>::operator[](int offset) const {
+  return element(index_ + offset);
+}
+
+template <typename T, size_t BlockSize>
+ChunkedDequeIterator<T, BlockSize>& ChunkedDequeIterator<T, BlockSize>::operator++() {
+  index_++;
+  return *this;
+}
+
+template <typename T, size_t BlockSize>
+ChunkedDequeIterator<T, BlockSize>& ChunkedDequeIterator<T, BlockSize>::operator--() {
+  index_--;
+  return *this;
+}
+
+template <typename T, size_t BlockSize>
+ChunkedDequeIterator<T, BlockSize> ChunkedDequeIterator<T, BlockSize>::operator++(int) {
+  ChunkedDequeIterator temp = *this;
+  index_++;
+  return temp;
+}
+
+template <typename T, size_t BlockSize>
+ChunkedDequeIterator<T, BlockSize> ChunkedDequeIterator<T, BlockSize>::operator--(int) {
+  ChunkedDequeIterator temp = *this;
+  index_--;
+  return temp;
+}
+
+template <typename T, size_t BlockSize>
+ChunkedDequeIterator<T, BlockSize>& ChunkedDequeIterator<T, BlockSize>::operator+=(int offset) {
+  index_ += offset;
+  return *this;
+}
+
+template <typename T, size_t BlockSize>
+ChunkedDequeIterator<T, BlockSize>& ChunkedDequeIterator<T, BlockSize>::operator-=(int offset) {
+  index_ -= offset;
+  return *this;
+}
+
+template <typename T, size_t BlockSize>
+ChunkedDequeIterator<T, BlockSize> ChunkedDequeIterator<T, BlockSize>::operator+(int offset) const {
+  ChunkedDequeIterator it = *this;
+  it.index_ += offset;
+  return it;
+}
+
+template <typename T, size_t BlockSize>
+ChunkedDequeIterator<T, BlockSize> operator+(int offset,
+    const ChunkedDequeIterator<T, BlockSize>& it) {
+  return it.operator+(offset);
+}
+
+template <typename T, size_t BlockSize>
+ChunkedDequeIterator<T, BlockSize> ChunkedDequeIterator<T, BlockSize>::operator-(int offset) const {
+  return operator+(-offset);
+}
+
+template <typename T, size_t BlockSize>
+int ChunkedDequeIterator<T, BlockSize>::operator-(const ChunkedDequeIterator& it) const {
+  return ((int) index_) - ((int) it.index_);
+}
+
+template <typename T, size_t BlockSize>
+bool ChunkedDequeIterator<T, BlockSize>::operator==(const ChunkedDequeIterator& it) const {
+  return same_container(it) && index_ == it.index_;
+}
+
+template <typename T, size_t BlockSize>
+bool ChunkedDequeIterator<T, BlockSize>::operator!=(const ChunkedDequeIterator& it) const {
+  return !same_container(it) || index_ != it.index_;
+}
+
+template <typename T, size_t BlockSize>
+bool ChunkedDequeIterator<T, BlockSize>::operator<=(const ChunkedDequeIterator& it) const {
+  return same_container(it) && index_ <= it.index_;
+}
+
+template <typename T, size_t BlockSize>
+bool ChunkedDequeIterator<T, BlockSize>::operator>=(const ChunkedDequeIterator& it) const {
+  return same_container(it) && index_ >= it.index_;
+}
+
+template <typename T, size_t BlockSize>
+bool ChunkedDequeIterator<T, BlockSize>::operator<(const ChunkedDequeIterator& it) const {
+  return same_container(it) && index_ < it.index_;
+}
+
+template <typename T, size_t BlockSize>
+bool ChunkedDequeIterator<T, BlockSize>::operator>(const ChunkedDequeIterator& it) const {
+  return same_container(it) && index_ > it.index_;
+}
+
+template <typename T, size_t BlockSize>
+T& ChunkedDequeIterator<T, BlockSize>::element(size_t index) const {
+  size_t position = front_ + index;
+  return map_[(map_head_ + position / BlockSize) % map_capacity_][position % BlockSize];
+}
+
+template <typename T, size_t BlockSize>
+bool ChunkedDequeIterator<T, BlockSize>::same_container(const ChunkedDequeIterator& it) const {
+  return map_ == it.map_ && map_head_ == it.map_head_ && size_ == it.size_
+    && front_ == it.front_;
+}
+}
+#endif
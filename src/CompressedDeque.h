@@ -0,0 +1,323 @@
+#ifndef _FDT_COMPRESSED_DEQUE_H_
+#define _FDT_COMPRESSED_DEQUE_H_
+
+#include "Deque.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <limits>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+
+namespace fdt {
+// Queue of unsigned integers that stores them delta-encoded. Values are kept
+// in blocks of BLOCK_SIZE: a block holds its first value and the differences
+// between neighbours, zigzag-encoded so that decreasing runs stay small and
+// bit-packed at the width of the largest one. For steadily growing series
+// such as timestamps and sequence numbers a difference takes one or two bytes
+// instead of eight.
+//
+// Sealed blocks sit in a Deque and their packed words in a second Deque, so
+// both grow at the back and shrink at the front like the values. The newest
+// block is kept unpacked until it fills up, which makes push_back and back()
+// plain array accesses. Random access skips straight to the block and decodes
+// up to the element within it.
+template <typename T = uint64_t>
+class CompressedDeque {
+  static_assert(std::is_unsigned<T>::value, "CompressedDeque: T must be an unsigned integer");
+
+public:
+  CompressedDeque();
+
+  void push_back(T value);
+  void pop_front();
+  void clear();
+
+  T front() const;
+  T back() const;
+  T at(size_t index) const;
+  T operator[](size_t index) const;
+
+  // Calls f(T) on every value from front to back, decoding a block at a time.
+  template <class Function>
+  void for_each(Function f) const;
+  // Writes the values [index, index + count) to `out`.
+  void copy(size_t index, size_t count, T* out) const;
+
+  size_t size() const;
+  bool empty() const;
+  // Bytes of storage currently allocated for the values.
+  size_t memory_usage() const;
+
+  static const size_t BLOCK_SIZE = 128;
+
+private:
+  struct Block {
+    T first;
+    uint64_t word;  // sequence number of its first packed word
+    uint32_t width;
+  };
+
+  static const size_t BITS = std::numeric_limits<T>::digits;
+
+  Deque<Block> blocks_;
+  Deque<uint64_t> words_;
+  uint64_t word_base_;
+  T tail_[BLOCK_SIZE];
+  size_t tail_size_;
+  size_t front_;  // index of the front value within the first block
+  size_t size_;
+
+  void seal();
+  void decode(const Block& block, T* out) const;
+  T decode(const Block& block, size_t count) const;
+  void load(const Block& block, size_t count, uint64_t* words) const;
+  T element(size_t index) const;
+  static size_t word_count(uint32_t width);
+  static T zigzag(T delta);
+  static T unzigzag(T encoded);
+  void check_nonempty() const;
+};
+
+template <typename T>
+CompressedDeque<T>::CompressedDeque()
+    : blocks_(16), words_(256), word_base_(0), tail_size_(0), front_(0), size_(0) {}
+
+template <typename T>
+void CompressedDeque<T>::push_back(T value) {
+  if (tail_size_ == BLOCK_SIZE) {
+    seal();
+  }
+  tail_[tail_size_++] = value;
+  size_++;
+}
+
+template <typename T>
+void CompressedDeque<T>::pop_front() {
+  check_nonempty();
+  front_++;
+  size_--;
+  if (size_ == 0) {
+    clear();
+  } else if (front_ == BLOCK_SIZE) {
+    // A full front block is always a sealed one: the unpacked block is only
+    // full while it still has values.
+    for (size_t i = word_count(blocks_.front().width); i > 0; i--) {
+      words_.pop_front();
+    }
+    word_base_ += word_count(blocks_.front().width);
+    blocks_.pop_front();
+    front_ = 0;
+  }
+}
+
+template <typename T>
+void CompressedDeque<T>::clear() {
+  blocks_.clear();
+  words_.clear();
+  word_base_ = 0;
+  tail_size_ = 0;
+  front_ = 0;
+  size_ = 0;
+}
+
+template <typename T>
+T CompressedDeque<T>::front() const {
+  check_nonempty();
+  return element(0);
+}
+
+template <typename T>
+T CompressedDeque<T>::back() const {
+  check_nonempty();
+  return tail_[tail_size_ - 1];
+}
+
+template <typename T>
+T CompressedDeque<T>::at(size_t index) const {
+  if (index >= size_) {
+    throw std::out_of_range("CompressedDeque: index " + std::to_string(index)
+        + " is out of range for size " + std::to_string(size_));
+  }
+  return element(index);
+}
+
+template <typename T>
+T CompressedDeque<T>::operator[](size_t index) const {
+  return element(index);
+}
+
+template <typename T>
+template <class Function>
+void CompressedDeque<T>::for_each(Function f) const {
+  T values[BLOCK_SIZE];
+  size_t from = front_;
+  for (size_t i = 0; i < blocks_.size(); i++) {
+    decode(blocks_[i], values);
+    for (size_t j = from; j < BLOCK_SIZE; j++) {
+      f(values[j]);
+    }
+    from = 0;
+  }
+  for (size_t j = from; j < tail_size_; j++) {
+    f(tail_[j]);
+  }
+}
+
+template <typename T>
+void CompressedDeque<T>::copy(size_t index, size_t count, T* out) const {
+  if (index > size_ || count > size_ - index) {
+    throw std::out_of_range("CompressedDeque: range [" + std::to_string(index) + ", "
+        + std::to_string(index + count) + ") is out of range for size " + std::to_string(size_));
+  }
+  T values[BLOCK_SIZE];
+  size_t position = front_ + index;
+  while (count > 0) {
+    size_t block = position / BLOCK_SIZE;
+    size_t offset = position % BLOCK_SIZE;
+    size_t run = std::min(count, BLOCK_SIZE - offset);
+    const T* source = tail_;
+    if (block < blocks_.size()) {
+      decode(blocks_[block], values);
+      source = values;
+    }
+    std::copy(source + offset, source + offset + run, out);
+    out += run;
+    position += run;
+    count -= run;
+  }
+}
+
+template <typename T>
+size_t CompressedDeque<T>::size() const {
+  return size_;
+}
+
+template <typename T>
+bool CompressedDeque<T>::empty() const {
+  return size_ == 0;
+}
+
+template <typename T>
+size_t CompressedDeque<T>::memory_usage() const {
+  return blocks_.capacity() * sizeof(Block) + words_.capacity() * sizeof(uint64_t) + sizeof(tail_);
+}
+
+// Packs the full unpacked block. Each block gets one spare word at the end so
+// that decoding may always read the word after the one a value starts in.
+template <typename T>
+void CompressedDeque<T>::seal() {
+  T deltas[BLOCK_SIZE];
+  T any = 0;
+  for (size_t i = 1; i < BLOCK_SIZE; i++) {
+    deltas[i] = zigzag(tail_[i] - tail_[i - 1]);
+    any |= deltas[i];
+  }
+  uint32_t width = 0;
+  while (width < BITS && (any >> width) != 0) {
+    width++;
+  }
+  blocks_.push_back(Block{tail_[0], word_base_ + words_.size(), width});
+  size_t count = word_count(width);
+  size_t first = words_.size();
+  words_.resize(first + count, 0);
+  for (size_t i = 1; i < BLOCK_SIZE && width > 0; i++) {
+    size_t bit = (i - 1) * width;
+    uint64_t value = deltas[i];
+    words_[first + bit / 64] |= value << (bit % 64);
+    if (bit % 64 + width > 64) {
+      words_[first + bit / 64 + 1] |= value >> (64 - bit % 64);
+    }
+  }
+  tail_size_ = 0;
+}
+
+// Unpacks a whole block. The unpacking loop has no branches and no
+// dependency between iterations, so the compiler can vectorize it; only the
+// prefix sum that follows is sequential.
+template <typename T>
+void CompressedDeque<T>::decode(const Block& block, T* out) const {
+  if (block.width == 0) {
+    std::fill(out, out + BLOCK_SIZE, block.first);
+    return;
+  }
+  uint64_t words[BLOCK_SIZE];
+  load(block, word_count(block.width), words);
+  uint64_t mask = block.width == 64 ? ~uint64_t(0) : (uint64_t(1) << block.width) - 1;
+  out[0] = block.first;
+  for (size_t i = 1; i < BLOCK_SIZE; i++) {
+    size_t bit = (i - 1) * block.width;
+    size_t shift = bit % 64;
+    uint64_t low = words[bit / 64] >> shift;
+    // Two shifts so that a shift of 64 never happens when shift is 0.
+    uint64_t high = (words[bit / 64 + 1] << 1) << (63 - shift);
+    out[i] = unzigzag((T) ((low | high) & mask));
+  }
+  for (size_t i = 1; i < BLOCK_SIZE; i++) {
+    out[i] += out[i - 1];
+  }
+}
+
+// Returns the value at `count` within a block.
+template <typename T>
+T CompressedDeque<T>::decode(const Block& block, size_t count) const {
+  T value = block.first;
+  if (block.width == 0) {
+    return value;
+  }
+  uint64_t words[BLOCK_SIZE];
+  load(block, count == 0 ? 0 : (count - 1) * block.width / 64 + 2, words);
+  uint64_t mask = block.width == 64 ? ~uint64_t(0) : (uint64_t(1) << block.width) - 1;
+  for (size_t i = 1; i <= count; i++) {
+    size_t bit = (i - 1) * block.width;
+    size_t shift = bit % 64;
+    uint64_t low = words[bit / 64] >> shift;
+    uint64_t high = (words[bit / 64 + 1] << 1) << (63 - shift);
+    value += unzigzag((T) ((low | high) & mask));
+  }
+  return value;
+}
+
+// Copies the first `count` packed words of a block out of the ring.
+template <typename T>
+void CompressedDeque<T>::load(const Block& block, size_t count, uint64_t* words) const {
+  size_t first = block.word - word_base_;
+  for (size_t i = 0; i < count; i++) {
+    words[i] = words_[first + i];
+  }
+}
+
+template <typename T>
+T CompressedDeque<T>::element(size_t index) const {
+  size_t position = front_ + index;
+  size_t block = position / BLOCK_SIZE;
+  if (block < blocks_.size()) {
+    return decode(blocks_[block], position % BLOCK_SIZE);
+  }
+  return tail_[position % BLOCK_SIZE];
+}
+
+template <typename T>
+size_t CompressedDeque<T>::word_count(uint32_t width) {
+  return width == 0 ? 0 : ((BLOCK_SIZE - 1) * width + 63) / 64 + 1;
+}
+
+template <typename T>
+T CompressedDeque<T>::zigzag(T delta) {
+  return (T) (delta << 1) ^ (T) (T(0) - (delta >> (BITS - 1)));
+}
+
+template <typename T>
+T CompressedDeque<T>::unzigzag(T encoded) {
+  return (T) (encoded >> 1) ^ (T) (T(0) - (encoded & 1));
+}
+
+template <typename T>
+void CompressedDeque<T>::check_nonempty() const {
+  if (size_ == 0) {
+    throw std::out_of_range("CompressedDeque: deque is empty");
+  }
+}
+}
+#endif
@@ -0,0 +1,310 @@
+#ifndef _FDT_CONCURRENT_DEQUE_H_
+#define _FDT_CONCURRENT_DEQUE_H_
+
+#include <algorithm>
+#include <atomic>
+#include <memory>
+#include <new>
+#include <stdexcept>
+#include <thread>
+#include <utility>
+
+namespace fdt {
+// Deque that any number of threads may push to and pop from at both ends.
+// The head and the tail each have their own spinlock, so one thread working
+// at the front and one at the back proceed in parallel.
+//
+// Every operation takes the lock of its own end and then claims its element
+// (pop) or slot (push) with a compare-and-swap on the shared size, which only
+// succeeds while the size is at least 2 for a pop, or at most capacity - 2
+// for a push. At most one operation per end is in flight, so then the two
+// ends touch different slots and the operation completes under its own lock.
+// It is linearized at the claim. Otherwise nothing is claimed and the
+// operation retakes both locks, head before tail, and runs with the deque to
+// itself: the lone last element, the last free slot, an empty pop and growth
+// are all decided there, and the operation is linearized inside that
+// section. The size never leaves [0, capacity], so size() and empty() only
+// ever see real states.
+template <typename T, class Allocator = std::allocator<T>>
+class ConcurrentDeque {
+public:
+  ConcurrentDeque();
+  explicit ConcurrentDeque(size_t capacity, const Allocator& alloca = Allocator());
+  ConcurrentDeque(const ConcurrentDeque&) = delete;
+  ConcurrentDeque& operator=(const ConcurrentDeque&) = delete;
+  ~ConcurrentDeque();
+
+  void push_front(T value);
+  void push_back(T value);
+  T pop_front();
+  T pop_back();
+  bool try_push_front(T value);
+  bool try_push_back(T value);
+  bool try_pop_front(T& value);
+  bool try_pop_back(T& value);
+
+  size_t capacity() const;
+  size_t size() const;
+  bool empty() const;
+
+private:
+  class alignas(64) SpinLock {
+  public:
+    SpinLock() : locked_(false) {}
+    void lock();
+    void unlock();
+
+  private:
+    std::atomic<bool> locked_;
+  };
+
+  enum class End { Front, Back };
+
+  T* container_;
+  Allocator alloca_;
+  size_t capacity_;
+  // Physical slot of the front element, and one past the back element. Each
+  // is changed only under its own lock; the buffer fields only under both.
+  size_t head_;
+  size_t tail_;
+  alignas(64) std::atomic<size_t> size_;
+  mutable SpinLock head_lock_;
+  mutable SpinLock tail_lock_;
+
+  static const size_t DEFAULT_CAPACITY = 64;
+  static const size_t MIN_CAPACITY = 4;
+
+  bool push(End end, T& value, bool grow);
+  bool pop(End end, T& value);
+  void put(End end, T& value);
+  T take(End end);
+  void lock_both(End end);
+  void unlock_both();
+  void reallocate();
+};
+
+template <typename T, class Allocator>
+void ConcurrentDeque<T, Allocator>::SpinLock::lock() {
+  int spins = 0;
+  while (true) {
+    if (!locked_.load(std::memory_order_relaxed)
+        && !locked_.exchange(true, std::memory_order_acquire)) {
+      return;
+    }
+    if (++spins == 64) {
+      spins = 0;
+      std::this_thread::yield();
+    }
+  }
+}
+
+template <typename T, class Allocator>
+void ConcurrentDeque<T, Allocator>::SpinLock::unlock() {
+  locked_.store(false, std::memory_order_release);
+}
+
+template <typename T, class Allocator>
+ConcurrentDeque<T, Allocator>::ConcurrentDeque() : ConcurrentDeque(DEFAULT_CAPACITY) {}
+
+template <typename T, class Allocator>
+ConcurrentDeque<T, Allocator>::ConcurrentDeque(size_t capacity, const Allocator& alloca)
+    : alloca_(alloca), capacity_(std::max(capacity, (size_t) MIN_CAPACITY)), head_(0), tail_(0),
+      size_(0) {
+  container_ = alloca_.allocate(capacity_);
+}
+
+template <typename T, class Allocator>
+ConcurrentDeque<T, Allocator>::~ConcurrentDeque() {
+  size_t size = size_.load();
+  for (size_t i = 0, position = head_; i < size; i++) {
+    container_[position].~T();
+    position = position + 1 == capacity_ ? 0 : position + 1;
+  }
+  alloca_.deallocate(container_, capacity_);
+}
+
+template <typename T, class Allocator>
+void ConcurrentDeque<T, Allocator>::push_front(T value) {
+  push(End::Front, value, true);
+}
+
+template <typename T, class Allocator>
+void ConcurrentDeque<T, Allocator>::push_back(T value) {
+  push(End::Back, value, true);
+}
+
+template <typename T, class Allocator>
+T ConcurrentDeque<T, Allocator>::pop_front() {
+  T value;
+  if (!pop(End::Front, value)) {
+    throw std::out_of_range("ConcurrentDeque: cannot pop from empty deque");
+  }
+  return value;
+}
+
+template <typename T, class Allocator>
+T ConcurrentDeque<T, Allocator>::pop_back() {
+  T value;
+  if (!pop(End::Back, value)) {
+    throw std::out_of_range("ConcurrentDeque: cannot pop from empty deque");
+  }
+  return value;
+}
+
+// Fails instead of growing when the deque is full.
+template <typename T, class Allocator>
+bool ConcurrentDeque<T, Allocator>::try_push_front(T value) {
+  return push(End::Front, value, false);
+}
+
+template <typename T, class Allocator>
+bool ConcurrentDeque<T, Allocator>::try_push_back(T value) {
+  return push(End::Back, value, false);
+}
+
+template <typename T, class Allocator>
+bool ConcurrentDeque<T, Allocator>::try_pop_front(T& value) {
+  return pop(End::Front, value);
+}
+
+template <typename T, class Allocator>
+bool ConcurrentDeque<T, Allocator>::try_pop_back(T& value) {
+  return pop(End::Back, value);
+}
+
+// Takes the tail lock for a moment so that a concurrent growth cannot be
+// observed half done.
+template <typename T, class Allocator>
+size_t ConcurrentDeque<T, Allocator>::capacity() const {
+  tail_lock_.lock();
+  size_t capacity = capacity_;
+  tail_lock_.unlock();
+  return capacity;
+}
+
+template <typename T, class Allocator>
+size_t ConcurrentDeque<T, Allocator>::size() const {
+  return size_.load();
+}
+
+template <typename T, class Allocator>
+bool ConcurrentDeque<T, Allocator>::empty() const {
+  return size_.load() == 0;
+}
+
+template <typename T, class Allocator>
+bool ConcurrentDeque<T, Allocator>::push(End end, T& value, bool grow) {
+  SpinLock& lock = end == End::Front ? head_lock_ : tail_lock_;
+  lock.lock();
+  size_t size = size_.load();
+  while (size + 2 <= capacity_) {
+    if (size_.compare_exchange_weak(size, size + 1)) {
+      put(end, value);
+      lock.unlock();
+      return true;
+    }
+  }
+  if (end == End::Back) {
+    lock.unlock();
+  }
+  lock_both(end);
+  if (size_.load() == capacity_) {
+    if (!grow) {
+      unlock_both();
+      return false;
+    }
+    reallocate();
+  }
+  size_.fetch_add(1);
+  put(end, value);
+  unlock_both();
+  return true;
+}
+
+template <typename T, class Allocator>
+bool ConcurrentDeque<T, Allocator>::pop(End end, T& value) {
+  SpinLock& lock = end == End::Front ? head_lock_ : tail_lock_;
+  lock.lock();
+  size_t size = size_.load();
+  while (size >= 2) {
+    if (size_.compare_exchange_weak(size, size - 1)) {
+      value = take(end);
+      lock.unlock();
+      return true;
+    }
+  }
+  if (end == End::Back) {
+    lock.unlock();
+  }
+  lock_both(end);
+  if (size_.load() == 0) {
+    unlock_both();
+    return false;
+  }
+  size_.fetch_sub(1);
+  value = take(end);
+  unlock_both();
+  return true;
+}
+
+template <typename T, class Allocator>
+void ConcurrentDeque<T, Allocator>::put(End end, T& value) {
+  if (end == End::Front) {
+    size_t head = head_ == 0 ? capacity_ - 1 : head_ - 1;
+    new (container_ + head) T(std::move(value));
+    head_ = head;
+  } else {
+    new (container_ + tail_) T(std::move(value));
+    tail_ = tail_ + 1 == capacity_ ? 0 : tail_ + 1;
+  }
+}
+
+template <typename T, class Allocator>
+T ConcurrentDeque<T, Allocator>::take(End end) {
+  size_t position;
+  if (end == End::Front) {
+    position = head_;
+    head_ = head_ + 1 == capacity_ ? 0 : head_ + 1;
+  } else {
+    position = tail_ == 0 ? capacity_ - 1 : tail_ - 1;
+    tail_ = position;
+  }
+  T value = std::move(container_[position]);
+  container_[position].~T();
+  return value;
+}
+
+// Called with the head lock held for End::Front and with no lock held for
+// End::Back; returns with both held.
+template <typename T, class Allocator>
+void ConcurrentDeque<T, Allocator>::lock_both(End end) {
+  if (end == End::Back) {
+    head_lock_.lock();
+  }
+  tail_lock_.lock();
+}
+
+template <typename T, class Allocator>
+void ConcurrentDeque<T, Allocator>::unlock_both() {
+  tail_lock_.unlock();
+  head_lock_.unlock();
+}
+
+template <typename T, class Allocator>
+void ConcurrentDeque<T, Allocator>::reallocate() {
+  size_t capacity = capacity_ * 2;
+  T* container = alloca_.allocate(capacity);
+  size_t size = size_.load();
+  for (size_t i = 0, position = head_; i < size; i++) {
+    new (container + i) T(std::move(container_[position]));
+    container_[position].~T();
+    position = position + 1 == capacity_ ? 0 : position + 1;
+  }
+  alloca_.deallocate(container_, capacity_);
+  container_ = container;
+  capacity_ = capacity;
+  head_ = 0;
+  tail_ = size;
+}
+}
+#endif
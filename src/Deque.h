@@ -1,6 +1,8 @@
 #ifndef _FDT_DEQUE_H_
 #define _FDT_DEQUE_H_
 #include "DequeIterator.h"
+#include "Span.h"
+#include "Stats.h"
 
 #include <string>
 #include <ostream>
@@ -9,15 +11,24 @@
 #include <stdexcept>
 #include <memory>
 #include <iostream>
+#include <iterator>
+#include <algorithm>
+#include <type_traits>
+#include <cstring>
+#include <cerrno>
+#include <system_error>
+
+#include <sys/types.h>
+#include <sys/uio.h>
 
 namespace fdt {
 template<typename T> class DequeIterator;
-template<typename T,  class Allocator = std::allocator<T> >
-class Deque {
+template<typename T,  class Allocator = std::allocator<T>, class Stats = NoStats>
+class Deque : private Stats {
 public:
   Deque();
   Deque(size_t capacity, const Allocator& alloca = Allocator());
-  Deque(const Deque<T>& deque, const Allocator& alloca = Allocator());
+  Deque(const Deque& deque, const Allocator& alloca = Allocator());
   Deque(std::initializer_list<T> container, const Allocator& alloca = Allocator());
   ~Deque();
   Deque& operator=(const Deque& deque);
@@ -30,9 +41,15 @@ public:
   void erase(const DequeIterator<T>& begin, const DequeIterator<T>& end);
   void erase(const DequeIterator<T>& it);
   void insert(const DequeIterator<T>& it, T value);
+  void insert(const DequeIterator<T>& it, size_t count, const T& value);
+  template <typename ForwardIt,
+      typename = typename std::enable_if<!std::is_integral<ForwardIt>::value>::type>
+  void insert(const DequeIterator<T>& it, ForwardIt first, ForwardIt last);
   void reserve(size_t);
   void resize(size_t, T = T());
   void clear();
+  void set_incremental_growth(size_t step);
+  void set_gap_buffer(bool enabled);
 
   T& front();
   T& back();
@@ -45,14 +62,20 @@ public:
 
   DequeIterator<T> begin() const;
   DequeIterator<T> end() const;
+  Segments<T> segments();
+  Span<T> linearize();
+
+  // Byte deques only. Read up to max bytes from fd onto the back, or write up
+  // to max bytes from the front to fd, with one readv/writev call.
+  ssize_t read_from(int fd, size_t max);
+  ssize_t write_to(int fd, size_t max);
 
   size_t capacity() const;
   size_t size() const;
   bool empty() const;
   std::string to_string() const;
 
-  template <typename U>
-  friend std::ostream& operator<<(std::ostream& out, const Deque<U>& deque);
+  StatsSnapshot stats() const;
 
 private:
   T* container_;
@@ -60,27 +83,47 @@ private:
   size_t capacity_;
   size_t front_;
   size_t size_;
+  size_t growth_step_;
+  DequeMigration<T> migration_;
+  bool gap_buffer_;
+  size_t gap_;
 
   static const size_t DEFAULT_CAPACITY = 64;
+  static const size_t NO_GAP = (size_t) -1;
 
+  T& element(size_t position) const;
+  size_t position(size_t index) const;
+  T* allocate(size_t capacity);
+  void deallocate(T* container, size_t capacity);
   void reallocate();
+  void migrate(size_t count);
+  void finish_migration();
+  void move_gap(size_t index);
+  void close_gap();
+  size_t open_gap(size_t, size_t);
   void shift_left(size_t, size_t, size_t);
   void shift_right(size_t, size_t, size_t);
+  static void move_forward(T*, T*, size_t, std::true_type);
+  static void move_forward(T*, T*, size_t, std::false_type);
+  static void move_backward(T*, T*, size_t, std::true_type);
+  static void move_backward(T*, T*, size_t, std::false_type);
   void out_of_range(const char*, size_t, const char*, const char*, size_t) const;
   void check_nonempty() const;
+  static void check_bytes();
 };
 
-template <typename T, class Allocator> 
-Deque<T, Allocator>::Deque() : Deque(64) {}
+template <typename T, class Allocator, class Stats> 
+Deque<T, Allocator, Stats>::Deque() : Deque(64) {}
 
-template <typename T, class Allocator> 
-Deque<T, Allocator>::Deque(size_t capacity, const Allocator& alloca)
-    : alloca_(alloca), capacity_(capacity), size_(0), front_(0) {
-  container_ = alloca_.allocate(capacity_);
+template <typename T, class Allocator, class Stats> 
+Deque<T, Allocator, Stats>::Deque(size_t capacity, const Allocator& alloca)
+    : alloca_(alloca), capacity_(capacity), size_(0), front_(0), growth_step_(0),
+      gap_buffer_(false), gap_(NO_GAP) {
+  container_ = allocate(capacity_);
 }
 
-template <typename T, class Allocator> 
-Deque<T, Allocator>::Deque(const Deque<T>& deque, const Allocator& alloca)
+template <typename T, class Allocator, class Stats> 
+Deque<T, Allocator, Stats>::Deque(const Deque& deque, const Allocator& alloca)
     : Deque(deque.capacity_, alloca) {
   size_t i = 0;
   for (const T& value : deque) {
@@ -89,8 +132,8 @@ Deque<T, Allocator>::Deque(const Deque<T>& deque, const Allocator& alloca)
   size_ = deque.size_;
 }
 
-template <typename T, class Allocator> 
-Deque<T, Allocator>::Deque(std::initializer_list<T> container, const Allocator &alloca)
+template <typename T, class Allocator, class Stats> 
+Deque<T, Allocator, Stats>::Deque(std::initializer_list<T> container, const Allocator &alloca)
     : Deque(container.size() * 2, alloca) {
   size_t i = 0;
   for (const T& value : container) {
@@ -99,19 +142,27 @@ Deque<T, Allocator>::Deque(std::initializer_list<T> container, const Allocator &
   size_ = container.size();
 }
 
-template <typename T, class Allocator> 
-Deque<T, Allocator>::~Deque() {
-  alloca_.deallocate(container_, capacity_);
+template <typename T, class Allocator, class Stats> 
+Deque<T, Allocator, Stats>::~Deque() {
+  if (migration_.container != nullptr) {
+    deallocate(migration_.container, migration_.capacity);
+  }
+  deallocate(container_, capacity_);
 }
 
-template <typename T, class Allocator> 
-Deque<T, Allocator>& Deque<T, Allocator>::operator=(const Deque<T, Allocator>& deque) {
+template <typename T, class Allocator, class Stats> 
+Deque<T, Allocator, Stats>& Deque<T, Allocator, Stats>::operator=(const Deque<T, Allocator, Stats>& deque) {
+  if (this == &deque) {
+    return *this;
+  }
+  finish_migration();
+  gap_ = NO_GAP;
   size_ = deque.size_;
   front_ = 0;
   if (capacity_ < deque.capacity_) {
-    alloca_.deallocate(container_, capacity_);
+    deallocate(container_, capacity_);
     capacity_ = deque.capacity_ * 2;
-    container_ = alloca_.allocate(capacity_);
+    container_ = allocate(capacity_);
   }
   size_t i = 0;
   for (const T& value : deque) {
@@ -120,14 +171,16 @@ Deque<T, Allocator>& Deque<T, Allocator>::operator=(const Deque<T, Allocator>& d
   return *this;
 }
 
-template <typename T, class Allocator> 
-Deque<T, Allocator>& Deque<T, Allocator>::operator=(std::initializer_list<T> container) {
+template <typename T, class Allocator, class Stats> 
+Deque<T, Allocator, Stats>& Deque<T, Allocator, Stats>::operator=(std::initializer_list<T> container) {
+  finish_migration();
+  gap_ = NO_GAP;
   size_ = container.size();
   front_ = 0;
-  if (capacity_ < size_) {
-    alloca_.deallocate(container_, capacity_);
+  if (capacity_ <= size_) {
+    deallocate(container_, capacity_);
     capacity_ = size_ * 2;
-    alloca_.allocate(capacity_);
+    container_ = allocate(capacity_);
   }
   size_t i = 0;
   for (const T& value : container) {
@@ -136,36 +189,53 @@ Deque<T, Allocator>& Deque<T, Allocator>::operator=(std::initializer_list<T> con
   return *this;
 }
 
-template <typename T, class Allocator> 
-void Deque<T, Allocator>::push_front(T value) {
+template <typename T, class Allocator, class Stats> 
+void Deque<T, Allocator, Stats>::push_front(T value) {
+  close_gap();
   front_ = (front_ + capacity_- 1) % capacity_;
   container_[front_] = value;
   size_++;
+  Stats::on_push(size_);
   reallocate();
 }
 
-template <typename T, class Allocator> 
-void Deque<T, Allocator>::push_back(T value) {
+template <typename T, class Allocator, class Stats> 
+void Deque<T, Allocator, Stats>::push_back(T value) {
+  close_gap();
   container_[(front_ + size_) % capacity_] = value;
   size_++;
+  Stats::on_push(size_);
   reallocate();
 }
 
-template <typename T, class Allocator> 
-void Deque<T, Allocator>::pop_front() {
+template <typename T, class Allocator, class Stats> 
+void Deque<T, Allocator, Stats>::pop_front() {
   check_nonempty();
+  close_gap();
+  if (migration_.size != 0 && migration_.target == front_) {
+    migration_.target = (migration_.target + 1) % capacity_;
+    migration_.front = (migration_.front + 1) % migration_.capacity;
+    migration_.size--;
+  }
   size_--;
   front_ = (front_ + 1) % capacity_;
+  migrate(growth_step_);
 }
 
-template <typename T, class Allocator> 
-void Deque<T, Allocator>::pop_back() {
+template <typename T, class Allocator, class Stats> 
+void Deque<T, Allocator, Stats>::pop_back() {
   check_nonempty();
+  close_gap();
+  if (migration_.size != 0
+      && (migration_.target + migration_.size) % capacity_ == (front_ + size_) % capacity_) {
+    migration_.size--;
+  }
   size_--;
+  migrate(growth_step_);
 }
 
-template <typename T, class Allocator> 
-void Deque<T, Allocator>::erase(const DequeIterator<T>& begin, const DequeIterator<T>& end) {
+template <typename T, class Allocator, class Stats> 
+void Deque<T, Allocator, Stats>::erase(const DequeIterator<T>& begin, const DequeIterator<T>& end) {
   if (begin.index_ >= size_) {
     out_of_range("begin.index_", begin.index_, ">=", "this->size()", size_);
   }
@@ -175,7 +245,24 @@ void Deque<T, Allocator>::erase(const DequeIterator<T>& begin, const DequeIterat
   if (begin.index_ > end.index_) {
     out_of_range("begin.index_", begin.index_, ">", "end.index_", end.index_);
   }
+  finish_migration();
   size_t offset = end.index_ - begin.index_;
+  if (offset == 0) {
+    return;
+  }
+  if (gap_buffer_) {
+    // The erased elements join the gap, which only has to move if it does
+    // not touch them already.
+    if (gap_ == NO_GAP || end.index_ < gap_) {
+      move_gap(end.index_);
+    }
+    else if (begin.index_ > gap_) {
+      move_gap(begin.index_);
+    }
+    gap_ = begin.index_;
+    size_ -= offset;
+    return;
+  }
   if (begin.index_ + end.index_ < size_) {
     shift_right(0, begin.index_, offset);
     front_ = (front_ + offset) % capacity_;
@@ -186,134 +273,296 @@ void Deque<T, Allocator>::erase(const DequeIterator<T>& begin, const DequeIterat
   size_ -= offset;
 }
 
-template <typename T, class Allocator> 
-void Deque<T, Allocator>::erase(const DequeIterator<T>& it) {
+template <typename T, class Allocator, class Stats> 
+void Deque<T, Allocator, Stats>::erase(const DequeIterator<T>& it) {
   return erase(it, it + 1);
 }
 
-template <typename T, class Allocator> 
-void Deque<T, Allocator>::insert(const DequeIterator<T>& it, T value) {
-  std::cout << "t idx:" << it.index_ << std::endl;
-  if (it.index_ > size_) {
-    out_of_range("it.index_", it.index_, ">", "this->size()", size_);
-  }
-  if (it.index_ < size_ / 2) {
-    shift_left(0, it.index_, 1);
-    front_ = (front_ + capacity_ - 1) % capacity_;
+template <typename T, class Allocator, class Stats> 
+void Deque<T, Allocator, Stats>::insert(const DequeIterator<T>& it, T value) {
+  insert(it, 1, value);
+}
+
+template <typename T, class Allocator, class Stats>
+void Deque<T, Allocator, Stats>::insert(const DequeIterator<T>& it, size_t count,
+    const T& value) {
+  size_t position = open_gap(it.index_, count);
+  while (count > 0) {
+    size_t n = std::min(count, capacity_ - position);
+    std::fill(container_ + position, container_ + position + n, value);
+    position = (position + n) % capacity_;
+    count -= n;
   }
-  else {
-    shift_right(it.index_, size_, 1);
+  reallocate();
+}
+
+template <typename T, class Allocator, class Stats>
+template <typename ForwardIt, typename>
+void Deque<T, Allocator, Stats>::insert(const DequeIterator<T>& it, ForwardIt first,
+    ForwardIt last) {
+  size_t count = std::distance(first, last);
+  size_t position = open_gap(it.index_, count);
+  for (; first != last; ++first) {
+    container_[position] = *first;
+    position = position + 1 == capacity_ ? 0 : position + 1;
   }
-  std::cout << "front " << front_ << std::endl;
-  container_[(it.index_ + front_) % capacity_] = value;
-  size_++;
   reallocate();
 }
 
-template <typename T, class Allocator> 
-void Deque<T, Allocator>::reserve(size_t capacity) {
+template <typename T, class Allocator, class Stats> 
+void Deque<T, Allocator, Stats>::reserve(size_t capacity) {
+  finish_migration();
+  close_gap();
   if (capacity <= capacity_) {
     return;
   }
-  T* new_container = alloca_.allocate(capacity);
+  Stats::on_reserve(size_ * sizeof(T));
+  T* new_container = allocate(capacity);
   for (size_t i = 0; i < size_; i++) {
-    new_container[i] = container_[(i + front_) % capacity_];
+    new_container[i] = std::move(container_[(i + front_) % capacity_]);
   }
-  alloca_.deallocate(container_, capacity_);
+  deallocate(container_, capacity_);
   container_ = new_container;
   capacity_ = capacity;
   front_ = 0;
 }
 
-template <typename T, class Allocator>
-void Deque<T, Allocator>::resize(size_t size, T value) {
-  if (size > capacity_) {
-    reserve(size);
+template <typename T, class Allocator, class Stats>
+void Deque<T, Allocator, Stats>::resize(size_t size, T value) {
+  finish_migration();
+  close_gap();
+  if (size >= capacity_) {
+    reserve(std::max(capacity_ * 2, size + 1));
   }
   for (size_t i = front_ + size_; i < front_ + size; i++) {
     container_[i % capacity_] = value;
   }
   size_ = size;
+  Stats::on_push(size_);
 }
 
-template <typename T, class Allocator> 
-void Deque<T, Allocator>::clear() {
+template <typename T, class Allocator, class Stats> 
+void Deque<T, Allocator, Stats>::clear() {
+  if (migration_.container != nullptr) {
+    deallocate(migration_.container, migration_.capacity);
+    migration_ = DequeMigration<T>();
+  }
+  gap_ = NO_GAP;
   size_ = 0;
   front_ = 0;
 }
 
-template <typename T, class Allocator> 
-T& Deque<T, Allocator>::front() {
+// With a non-zero step, growing allocates the larger buffer but leaves the
+// elements where they are; every later push or pop then moves up to step of
+// them, so no single operation copies the whole deque. Zero restores the
+// all-at-once growth and finishes any growth in progress.
+template <typename T, class Allocator, class Stats>
+void Deque<T, Allocator, Stats>::set_incremental_growth(size_t step) {
+  growth_step_ = step;
+  if (step == 0) {
+    finish_migration();
+  }
+  else {
+    set_gap_buffer(false);
+  }
+}
+
+// In gap-buffer mode the free slots stay wherever the last insert() or
+// erase() left them, so further edits there shift nothing; only edits
+// elsewhere move the gap, by as many elements as lie in between. Pushes,
+// pops and the operations that need a plain ring close the gap first.
+// Incompatible with incremental growth, which enabling it switches off.
+template <typename T, class Allocator, class Stats>
+void Deque<T, Allocator, Stats>::set_gap_buffer(bool enabled) {
+  gap_buffer_ = enabled;
+  if (enabled) {
+    set_incremental_growth(0);
+  }
+  else {
+    close_gap();
+  }
+}
+
+template <typename T, class Allocator, class Stats> 
+T& Deque<T, Allocator, Stats>::front() {
   check_nonempty();
-  return container_[front_];
+  return element(position(0));
 }
 
-template <typename T, class Allocator> 
-T& Deque<T, Allocator>::back() {
+template <typename T, class Allocator, class Stats> 
+T& Deque<T, Allocator, Stats>::back() {
   check_nonempty();
-  return container_[(front_ + size_ - 1) % capacity_];
+  return element(position(size_ - 1));
 }
 
-template <typename T, class Allocator> 
-T& Deque<T, Allocator>::at(size_t index) {
+template <typename T, class Allocator, class Stats> 
+T& Deque<T, Allocator, Stats>::at(size_t index) {
   if (index >= size_) {
     out_of_range("index", index, ">=", "this->size()", size_);
   }
   return operator[](index);
 }
 
-template <typename T, class Allocator> 
-T& Deque<T, Allocator>::operator[](size_t index) {
-  return container_[(front_ + index) % capacity_];
+template <typename T, class Allocator, class Stats> 
+T& Deque<T, Allocator, Stats>::operator[](size_t index) {
+  return element(position(index));
 }
 
-template <typename T, class Allocator> 
-T Deque<T, Allocator>::front() const {
-  return front();
-}
-
-template <typename T, class Allocator> 
-T Deque<T, Allocator>::back() const {
-  return back();
-}
-
-template <typename T, class Allocator> 
-T Deque<T, Allocator>::at(size_t index) const {
-  return at(index);
-}
-
-template <typename T, class Allocator> 
-T Deque<T, Allocator>::operator[](size_t index) const {
-  return operator[](index);
+template <typename T, class Allocator, class Stats> 
+T Deque<T, Allocator, Stats>::front() const {
+  check_nonempty();
+  return element(position(0));
 }
 
-template <typename T, class Allocator> 
-DequeIterator<T> Deque<T,  Allocator>::begin() const {
-  return DequeIterator<T>(container_, capacity_, size_, front_, 0);
+template <typename T, class Allocator, class Stats> 
+T Deque<T, Allocator, Stats>::back() const {
+  check_nonempty();
+  return element(position(size_ - 1));
 }
 
-template <typename T, class Allocator> 
-DequeIterator<T> Deque<T, Allocator>::end() const {
-  return DequeIterator<T>(container_, capacity_, size_, front_, size_);
+template <typename T, class Allocator, class Stats> 
+T Deque<T, Allocator, Stats>::at(size_t index) const {
+  if (index >= size_) {
+    out_of_range("index", index, ">=", "this->size()", size_);
+  }
+  return element(position(index));
+}
+
+template <typename T, class Allocator, class Stats> 
+T Deque<T, Allocator, Stats>::operator[](size_t index) const {
+  return element(position(index));
+}
+
+template <typename T, class Allocator, class Stats> 
+DequeIterator<T> Deque<T, Allocator, Stats>::begin() const {
+  return DequeIterator<T>(container_, capacity_, size_, front_, 0, migration_,
+      DequeGap(gap_, capacity_ - size_));
+}
+
+template <typename T, class Allocator, class Stats> 
+DequeIterator<T> Deque<T, Allocator, Stats>::end() const {
+  return DequeIterator<T>(container_, capacity_, size_, front_, size_, migration_,
+      DequeGap(gap_, capacity_ - size_));
+}
+
+// The elements as they lie in the buffer: from the front to the end of the
+// buffer, then whatever wrapped around to its start. Finishes an incremental
+// growth first, since the two buffers do not form two plain ranges.
+template <typename T, class Allocator, class Stats>
+Segments<T> Deque<T, Allocator, Stats>::segments() {
+  finish_migration();
+  close_gap();
+  size_t first = std::min(size_, capacity_ - front_);
+  Segments<T> segments;
+  segments.first = Span<T>(container_ + front_, first);
+  segments.second = Span<T>(container_, size_ - first);
+  return segments;
+}
+
+// Rotates the buffer in place so that the elements form one contiguous run
+// starting at the front of the buffer, and returns it.
+template <typename T, class Allocator, class Stats>
+Span<T> Deque<T, Allocator, Stats>::linearize() {
+  finish_migration();
+  close_gap();
+  if (front_ + size_ > capacity_) {
+    Stats::on_shift(capacity_ * sizeof(T));
+    std::rotate(container_, container_ + front_, container_ + capacity_);
+    front_ = 0;
+  }
+  return Span<T>(container_ + front_, size_);
+}
+
+// Reads straight into the free space after the back, which is at most two
+// pieces of the buffer, so one call reads no more than is free; like a push,
+// it grows the buffer once the read fills it. Returns the number of bytes
+// read, 0 at end of file, or -1 when fd is non-blocking and has nothing to
+// read; other errors throw system_error. A read that takes any bytes counts
+// as one push of all of them in the stats, as a range insert does.
+template <typename T, class Allocator, class Stats>
+ssize_t Deque<T, Allocator, Stats>::read_from(int fd, size_t max) {
+  check_bytes();
+  finish_migration();
+  close_gap();
+  if (size_ == 0) {
+    front_ = 0;
+  }
+  size_t back = (front_ + size_) % capacity_;
+  size_t first = std::min(max, (back < front_ ? front_ : capacity_) - back);
+  struct iovec iov[2];
+  iov[0].iov_base = container_ + back;
+  iov[0].iov_len = first;
+  iov[1].iov_base = container_;
+  iov[1].iov_len = std::min(max - first, back < front_ ? 0 : front_);
+  ssize_t count;
+  do {
+    count = ::readv(fd, iov, iov[1].iov_len == 0 ? 1 : 2);
+  } while (count < 0 && errno == EINTR);
+  if (count < 0) {
+    if (errno == EAGAIN || errno == EWOULDBLOCK) {
+      return -1;
+    }
+    throw std::system_error(errno, std::generic_category(), "Deque: readv failed");
+  }
+  if (count > 0) {
+    size_ += count;
+    Stats::on_push(size_);
+    reallocate();
+  }
+  return count;
+}
+
+// Writes from the front, at most two pieces of the buffer, and pops whatever
+// was written. Returns the number of bytes written, or -1 when fd is
+// non-blocking and cannot take any; other errors throw system_error. A write
+// that takes any bytes counts as one pop in the stats.
+template <typename T, class Allocator, class Stats>
+ssize_t Deque<T, Allocator, Stats>::write_to(int fd, size_t max) {
+  check_bytes();
+  Segments<T> used = segments();
+  struct iovec iov[2];
+  iov[0].iov_base = used.first.data();
+  iov[0].iov_len = std::min(max, used.first.size());
+  iov[1].iov_base = used.second.data();
+  iov[1].iov_len = std::min(max - iov[0].iov_len, used.second.size());
+  if (iov[0].iov_len == 0) {
+    return 0;
+  }
+  ssize_t count;
+  do {
+    count = ::writev(fd, iov, iov[1].iov_len == 0 ? 1 : 2);
+  } while (count < 0 && errno == EINTR);
+  if (count < 0) {
+    if (errno == EAGAIN || errno == EWOULDBLOCK) {
+      return -1;
+    }
+    throw std::system_error(errno, std::generic_category(), "Deque: writev failed");
+  }
+  if (count > 0) {
+    size_ -= count;
+    front_ = size_ == 0 ? 0 : (front_ + count) % capacity_;
+    Stats::on_pop();
+  }
+  return count;
 }
 
-template <typename T, class Allocator> 
-size_t Deque<T, Allocator>::capacity() const {
+template <typename T, class Allocator, class Stats> 
+size_t Deque<T, Allocator, Stats>::capacity() const {
   return capacity_;
 }
 
-template <typename T, class Allocator> 
-size_t Deque<T, Allocator>::size() const {
+template <typename T, class Allocator, class Stats> 
+size_t Deque<T, Allocator, Stats>::size() const {
   return size_;
 }
 
-template <typename T, class Allocator> 
-bool Deque<T, Allocator>::empty() const {
+template <typename T, class Allocator, class Stats> 
+bool Deque<T, Allocator, Stats>::empty() const {
   return size_ == 0;
 }
 
-template <typename T, class Allocator>
-std::string Deque<T, Allocator>::to_string() const {
+template <typename T, class Allocator, class Stats>
+std::string Deque<T, Allocator, Stats>::to_string() const {
   std::ostringstream out;
   out << "[ ";
   for (const T& value : *this) {
@@ -323,36 +572,251 @@ std::string Deque<T, Allocator>::to_string() const {
   return out.str();
 }
 
-template <typename T> 
+template <typename T, class Allocator, class Stats>
+StatsSnapshot Deque<T, Allocator, Stats>::stats() const {
+  return Stats::snapshot();
+}
+
+template <typename T, class Allocator, class Stats>
 std::ostream& operator<<(std::ostream& out,
-    const Deque<T>& deque) {
+    const Deque<T, Allocator, Stats>& deque) {
   return out << deque.to_string();
 }
 
-template <typename T, class Allocator> 
-inline void Deque<T, Allocator>::reallocate() {
+template <typename T, class Allocator, class Stats>
+inline T& Deque<T, Allocator, Stats>::element(size_t position) const {
+  if (migration_.size != 0) {
+    T* pending = migration_.locate(position, capacity_);
+    if (pending != nullptr) {
+      return *pending;
+    }
+  }
+  return container_[position];
+}
+
+// Physical position of the element at index, past the gap if there is one.
+template <typename T, class Allocator, class Stats>
+inline size_t Deque<T, Allocator, Stats>::position(size_t index) const {
+  return (front_ + index + (index >= gap_ ? capacity_ - size_ : 0)) % capacity_;
+}
+
+template <typename T, class Allocator, class Stats> 
+inline void Deque<T, Allocator, Stats>::reallocate() {
   if (size_ < capacity_) {
+    migrate(growth_step_);
     return;
   }
-  reserve(capacity_ * 2);
+  Stats::on_reallocate();
+  // A full buffer has no free slots, so an open gap is empty and can be
+  // dropped without moving anything.
+  gap_ = NO_GAP;
+  if (growth_step_ == 0) {
+    reserve(capacity_ * 2);
+    return;
+  }
+  finish_migration();
+  Stats::on_reserve(size_ * sizeof(T));
+  migration_.container = container_;
+  migration_.capacity = capacity_;
+  migration_.front = front_;
+  migration_.target = 0;
+  migration_.size = size_;
+  container_ = allocate(capacity_ * 2);
+  capacity_ *= 2;
+  front_ = 0;
+  migrate(growth_step_);
 }
 
-template <typename T, class Allocator> 
-void Deque<T, Allocator>::shift_left(size_t begin, size_t end, size_t offset) {
-  for (size_t i = begin + front_; i < end + front_; i++) {
-    container_[(i - offset) % capacity_] = container_[i % capacity_];
+// Moves up to count of the elements left in the old buffer by an incremental
+// growth, in contiguous pieces, and frees the old buffer once it is empty.
+template <typename T, class Allocator, class Stats>
+void Deque<T, Allocator, Stats>::migrate(size_t count) {
+  if (migration_.container == nullptr) {
+    return;
+  }
+  count = std::min(count, migration_.size);
+  while (count > 0) {
+    size_t n = std::min(count, std::min(migration_.capacity - migration_.front,
+        capacity_ - migration_.target));
+    std::move(migration_.container + migration_.front,
+        migration_.container + migration_.front + n, container_ + migration_.target);
+    migration_.front = (migration_.front + n) % migration_.capacity;
+    migration_.target = (migration_.target + n) % capacity_;
+    migration_.size -= n;
+    count -= n;
+  }
+  if (migration_.size == 0) {
+    deallocate(migration_.container, migration_.capacity);
+    migration_ = DequeMigration<T>();
   }
 }
 
-template <typename T, class Allocator> 
-void Deque<T, Allocator>::shift_right(size_t begin, size_t end, size_t offset) {
-  for (size_t i = end + front_ - 1; i >= begin + front_; i--) {
-    container_[(i + offset) % capacity_] = container_[i % capacity_];
+// Every slot of a buffer holds a live T from allocation to deallocation, so
+// elements can be assigned into free slots and popped ones are only
+// overwritten. Trivial types skip the construction.
+template <typename T, class Allocator, class Stats>
+T* Deque<T, Allocator, Stats>::allocate(size_t capacity) {
+  T* container = alloca_.allocate(capacity);
+  if (!std::is_trivial<T>::value) {
+    std::uninitialized_fill_n(container, capacity, T());
   }
+  return container;
 }
 
-template <typename T, class Allocator> 
-void Deque<T, Allocator>::out_of_range(const char* id_1, size_t value_1,
+template <typename T, class Allocator, class Stats>
+void Deque<T, Allocator, Stats>::deallocate(T* container, size_t capacity) {
+  if (!std::is_trivial<T>::value) {
+    for (size_t i = 0; i < capacity; i++) {
+      container[i].~T();
+    }
+  }
+  alloca_.deallocate(container, capacity);
+}
+
+template <typename T, class Allocator, class Stats>
+void Deque<T, Allocator, Stats>::finish_migration() {
+  migrate(migration_.size);
+}
+
+// Moves the gap, or opens one if there is none, to just before index by
+// shifting the elements in between across it. A new gap starts from
+// whichever end of the deque is closer.
+template <typename T, class Allocator, class Stats>
+void Deque<T, Allocator, Stats>::move_gap(size_t index) {
+  size_t free = capacity_ - size_;
+  if (gap_ == NO_GAP) {
+    if (index < size_ - index) {
+      front_ = (front_ + size_) % capacity_;
+      gap_ = 0;
+    }
+    else {
+      gap_ = size_;
+    }
+  }
+  if (index < gap_) {
+    shift_right(index, gap_, free);
+  }
+  else if (index > gap_) {
+    shift_left(gap_ + free, index + free, free);
+  }
+  gap_ = index;
+}
+
+// Closes the gap from whichever side is shorter, leaving a plain ring.
+template <typename T, class Allocator, class Stats>
+void Deque<T, Allocator, Stats>::close_gap() {
+  if (gap_ == NO_GAP) {
+    return;
+  }
+  size_t free = capacity_ - size_;
+  if (free == 0) {
+    gap_ = NO_GAP;
+    return;
+  }
+  if (gap_ < size_ - gap_) {
+    shift_right(0, gap_, free);
+    front_ = (front_ + free) % capacity_;
+  }
+  else {
+    shift_left(gap_ + free, size_ + free, free);
+  }
+  gap_ = NO_GAP;
+}
+
+// Makes room for count elements before index by shifting whichever side of
+// index is shorter, and returns the physical position of the first new slot.
+template <typename T, class Allocator, class Stats>
+size_t Deque<T, Allocator, Stats>::open_gap(size_t index, size_t count) {
+  if (index > size_) {
+    out_of_range("it.index_", index, ">", "this->size()", size_);
+  }
+  finish_migration();
+  if (size_ + count > capacity_) {
+    reserve(std::max(capacity_ * 2, size_ + count));
+  }
+  if (gap_buffer_) {
+    move_gap(index);
+    gap_ += count;
+    size_ += count;
+    Stats::on_push(size_);
+    return position(index);
+  }
+  if (index < size_ - index) {
+    shift_left(0, index, count);
+    front_ = (front_ + capacity_ - count) % capacity_;
+  }
+  else {
+    shift_right(index, size_, count);
+  }
+  size_ += count;
+  Stats::on_push(size_);
+  return (front_ + index) % capacity_;
+}
+
+// Moves the elements [begin, end) (indices relative to front_) offset slots
+// towards the front. The circular range is split into at most three pieces
+// that are contiguous in both source and destination and moved piecewise.
+template <typename T, class Allocator, class Stats> 
+void Deque<T, Allocator, Stats>::shift_left(size_t begin, size_t end, size_t offset) {
+  Stats::on_shift((end - begin) * sizeof(T));
+  size_t count = end - begin;
+  size_t from = (front_ + begin) % capacity_;
+  size_t to = (from + capacity_ - offset % capacity_) % capacity_;
+  while (count > 0) {
+    size_t n = std::min(count, std::min(capacity_ - from, capacity_ - to));
+    move_forward(container_ + to, container_ + from, n,
+        std::is_trivially_copyable<T>());
+    from = (from + n) % capacity_;
+    to = (to + n) % capacity_;
+    count -= n;
+  }
+}
+
+// Moves the elements [begin, end) offset slots towards the back, piecewise
+// from the back so that overlapping pieces are never overwritten early.
+template <typename T, class Allocator, class Stats> 
+void Deque<T, Allocator, Stats>::shift_right(size_t begin, size_t end, size_t offset) {
+  Stats::on_shift((end - begin) * sizeof(T));
+  size_t count = end - begin;
+  size_t from = (front_ + end) % capacity_;
+  size_t to = (from + offset) % capacity_;
+  while (count > 0) {
+    size_t n = std::min(count,
+        std::min(from == 0 ? capacity_ : from, to == 0 ? capacity_ : to));
+    from = (from == 0 ? capacity_ : from) - n;
+    to = (to == 0 ? capacity_ : to) - n;
+    move_backward(container_ + to, container_ + from, n,
+        std::is_trivially_copyable<T>());
+    count -= n;
+  }
+}
+
+template <typename T, class Allocator, class Stats>
+inline void Deque<T, Allocator, Stats>::move_forward(T* to, T* from, size_t count,
+    std::true_type) {
+  std::memmove(static_cast<void*>(to), static_cast<const void*>(from), count * sizeof(T));
+}
+
+template <typename T, class Allocator, class Stats>
+inline void Deque<T, Allocator, Stats>::move_forward(T* to, T* from, size_t count,
+    std::false_type) {
+  std::move(from, from + count, to);
+}
+
+template <typename T, class Allocator, class Stats>
+inline void Deque<T, Allocator, Stats>::move_backward(T* to, T* from, size_t count,
+    std::true_type) {
+  std::memmove(static_cast<void*>(to), static_cast<const void*>(from), count * sizeof(T));
+}
+
+template <typename T, class Allocator, class Stats>
+inline void Deque<T, Allocator, Stats>::move_backward(T* to, T* from, size_t count,
+    std::false_type) {
+  std::move_backward(from, from + count, to + count);
+}
+
+template <typename T, class Allocator, class Stats> 
+void Deque<T, Allocator, Stats>::out_of_range(const char* id_1, size_t value_1,
     const char* op, const char* id_2, size_t value_2) const {
   std::ostringstream out;
   out << "Deque: " << id_1 << " (which is " << value_1 << ") "
@@ -360,8 +824,14 @@ void Deque<T, Allocator>::out_of_range(const char* id_1, size_t value_1,
   throw std::out_of_range(out.str());
 }
 
-template <typename T, class Allocator> 
-void Deque<T, Allocator>::check_nonempty() const {
+template <typename T, class Allocator, class Stats>
+inline void Deque<T, Allocator, Stats>::check_bytes() {
+  static_assert(sizeof(T) == 1 && std::is_trivially_copyable<T>::value,
+      "Deque: read_from and write_to need a deque of bytes");
+}
+
+template <typename T, class Allocator, class Stats> 
+void Deque<T, Allocator, Stats>::check_nonempty() const {
   if (size_ == 0) {
     throw std::out_of_range("Deque: cannot access element in empty deque");
   }
@@ -1,30 +1,71 @@
 #ifndef _FDT_DEQUE_ITERATOR_H_
 #define _FDT_DEQUE_ITERATOR_H_
 
-#include "Deque.h"
-#include "LockfreeQueue.h"
+#include <cstddef>
+#include <iterator>
 
 namespace fdt {
+// State of an incremental growth: the elements that have not been moved to
+// the new buffer yet. They form one contiguous run of positions in the new
+// buffer, starting at target, and still live in the old buffer from front on.
+template <typename T>
+struct DequeMigration {
+  T* container;
+  size_t capacity;
+  size_t front;
+  size_t target;
+  size_t size;
+
+  DequeMigration() : container(nullptr), capacity(0), front(0), target(0), size(0) {}
+
+  T* locate(size_t position, size_t target_capacity) const {
+    size_t offset = (position + target_capacity - target) % target_capacity;
+    return offset < size ? container + (front + offset) % capacity : nullptr;
+  }
+};
+
+// The free slots a deque in gap-buffer mode keeps at its last edit: the
+// elements from index on lie size slots further along the buffer. An index
+// of -1 means there is no gap.
+struct DequeGap {
+  size_t index;
+  size_t size;
+
+  DequeGap() : index((size_t) -1), size(0) {}
+  DequeGap(size_t index, size_t size) : index(index), size(size) {}
+
+  size_t offset(size_t position) const {
+    return position >= index ? size : 0;
+  }
+};
+
 template <typename T>
 class DequeIterator {
 public:
-  DequeIterator(T* container, size_t capacity, size_t size, size_t front, size_t index);
+  typedef std::random_access_iterator_tag iterator_category;
+  typedef T value_type;
+  typedef std::ptrdiff_t difference_type;
+  typedef T* pointer;
+  typedef T& reference;
+
+  DequeIterator(T* container, size_t capacity, size_t size, size_t front, size_t index,
+      const DequeMigration<T>& migration = DequeMigration<T>(),
+      const DequeGap& gap = DequeGap());
   DequeIterator(const DequeIterator<T>& it);
   DequeIterator<T>& operator=(const DequeIterator& it);
 
-  T& operator*();
-  T& operator[](int);
-  T operator*() const;
-  T operator[](int) const;
+  T& operator*() const;
+  T* operator->() const;
+  T& operator[](difference_type offset) const;
   DequeIterator<T>& operator++();
   DequeIterator<T>& operator--();
   DequeIterator<T> operator++(int);
   DequeIterator<T> operator--(int);
-  DequeIterator<T>& operator+=(int);
-  DequeIterator<T>& operator-=(int);
-  DequeIterator<T> operator+(int offfset) const;
-  DequeIterator<T> operator-(int offset) const;
-  int operator-(const DequeIterator<T>& it) const;
+  DequeIterator<T>& operator+=(difference_type offset);
+  DequeIterator<T>& operator-=(difference_type offset);
+  DequeIterator<T> operator+(difference_type offset) const;
+  DequeIterator<T> operator-(difference_type offset) const;
+  difference_type operator-(const DequeIterator<T>& it) const;
   bool operator==(const DequeIterator<T>& it) const;
   bool operator!=(const DequeIterator<T>& it) const;
   bool operator<=(const DequeIterator<T>& it) const;
@@ -33,7 +74,7 @@ public:
   bool operator>(const DequeIterator<T>& it) const;
 
   template <typename U>
-  friend DequeIterator<U> operator+(int offset, const DequeIterator<U>& it);
+  friend DequeIterator<U> operator+(std::ptrdiff_t offset, const DequeIterator<U>& it);
 
 private:
   T* container_;
@@ -41,21 +82,29 @@ private:
   size_t size_;
   size_t front_;
   size_t index_;
+  DequeMigration<T> migration_;
+  DequeGap gap_;
+  // No migration is pending and no gap lies before the last element, so an
+  // element sits at (front_ + index) % capacity_.
+  bool plain_;
 
+  T& element(size_t index) const;
   bool same_container(const DequeIterator<T>& it) const;
 
-  template <typename, class> friend class Deque;
+  template <typename, class, class> friend class Deque;
   template <typename, class> friend class LockFreeDeque;
 };
 
 template <typename T>
 DequeIterator<T>::DequeIterator(T* container,
-    size_t capacity, size_t size, size_t front, size_t index)
+    size_t capacity, size_t size, size_t front, size_t index,
+    const DequeMigration<T>& migration, const DequeGap& gap)
     : container_(container), capacity_(capacity), size_(size), front_(front),
-      index_(index) {}
+      index_(index), migration_(migration), gap_(gap),
+      plain_(migration.size == 0 && gap.index >= size) {}
 
 template <typename T>
-DequeIterator<T>::DequeIterator(const DequeIterator<T>& it):DequeIterator(it.container_, it.capacity_, it.size_, it.front_, it.index_){ 
+DequeIterator<T>::DequeIterator(const DequeIterator<T>& it):DequeIterator(it.container_, it.capacity_, it.size_, it.front_, it.index_, it.migration_, it.gap_){ 
 }
 
 template <typename T> 
@@ -65,27 +114,25 @@ DequeIterator<T>& DequeIterator<T>::operator=(const DequeIterator& it) {
   size_ = it.size_;
   front_ = it.front_;
   index_ = it.index_;
+  migration_ = it.migration_;
+  gap_ = it.gap_;
+  plain_ = it.plain_;
   return *this;
 }
 
 template <typename T> 
-T& DequeIterator<T>::operator*() {
-  return container_[(index_ + front_) % capacity_];
+T& DequeIterator<T>::operator*() const {
+  return element(index_);
 }
 
 template <typename T> 
-T& DequeIterator<T>::operator[](int offset) {
-  return container_[(index_ + front_ + offset) % capacity_];
+T* DequeIterator<T>::operator->() const {
+  return &element(index_);
 }
 
 template <typename T> 
-T DequeIterator<T>::operator*() const {
-  return operator*();
-}
-
-template <typename T> 
-T DequeIterator<T>::operator[](int offset) const {
-  return operator[](offset);
+T& DequeIterator<T>::operator[](difference_type offset) const {
+  return element(index_ + offset);
 }
 
 template <typename T> 
@@ -116,39 +163,39 @@ DequeIterator<T> DequeIterator<T>::operator--(int) {
 }
 
 template <typename T>
-DequeIterator<T>& DequeIterator<T>::operator+=(int offset) {
+DequeIterator<T>& DequeIterator<T>::operator+=(difference_type offset) {
   index_ += offset;
   return *this;
 }
 
 template <typename T> 
-DequeIterator<T>& DequeIterator<T>::operator-=(int offset) {
+DequeIterator<T>& DequeIterator<T>::operator-=(difference_type offset) {
   index_ -= offset;
   return *this;
 }
 
 template <typename T> 
-DequeIterator<T> DequeIterator<T>::operator+(int offset) const {
-  return *this;
-  // DequeIterator<T> it = *this;
-  // it.index_ += offset;
-  // return it;
+DequeIterator<T> DequeIterator<T>::operator+(difference_type offset) const {
+  DequeIterator<T> it = *this;
+  it.index_ += offset;
+  return it;
 }
 
 
 template <typename T> 
-DequeIterator<T> operator+(int offset, const DequeIterator<T>& it) {
+DequeIterator<T> operator+(std::ptrdiff_t offset, const DequeIterator<T>& it) {
   return it.operator+(offset);
 }
 
 template <typename T> 
-DequeIterator<T> DequeIterator<T>::operator-(int offset) const {
+DequeIterator<T> DequeIterator<T>::operator-(difference_type offset) const {
   return operator+(-offset);
 }
 
 template <typename T>
-int DequeIterator<T>::operator-(const DequeIterator<T>& it) const {
-  return ((int) index_) - ((int) it.index_);
+typename DequeIterator<T>::difference_type DequeIterator<T>::operator-(
+    const DequeIterator<T>& it) const {
+  return (difference_type) index_ - (difference_type) it.index_;
 }
 
 template <typename T>
@@ -181,10 +228,30 @@ bool DequeIterator<T>::operator>(const DequeIterator<T>& it) const {
   return same_container(it) && index_ > it.index_;
 }
 
+template <typename T>
+T& DequeIterator<T>::element(size_t index) const {
+  if (plain_) {
+    return container_[(index + front_) % capacity_];
+  }
+  size_t position = (index + front_ + gap_.offset(index)) % capacity_;
+  if (migration_.size != 0) {
+    T* pending = migration_.locate(position, capacity_);
+    if (pending != nullptr) {
+      return *pending;
+    }
+  }
+  return container_[position];
+}
+
 template <typename T> 
 bool DequeIterator<T>::same_container(const DequeIterator<T>& it) const {
   return container_ == it.container_ && capacity_ && it.capacity_
-    && size_ == it.size_ && front_ == it.front_;
+    && size_ == it.size_ && front_ == it.front_
+    && migration_.size == it.migration_.size;
 }
 }
+
+// Included last so that DequeMigration is complete whichever header comes first.
+#include "Deque.h"
+#include "LockfreeQueue.h"
 #endif
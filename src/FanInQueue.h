@@ -0,0 +1,289 @@
+#ifndef _FDT_FAN_IN_QUEUE_H_
+#define _FDT_FAN_IN_QUEUE_H_
+
+#include "Layout.h"
+#include "LockfreeQueue.h"
+#include "OccupancyBitmap.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace fdt {
+enum class DrainPolicy {
+  RoundRobin,   // visit occupied shards in order, starting after the last one
+  LongestFirst  // visit occupied shards from the fullest to the emptiest
+};
+
+// Multi-producer single-consumer queue made of one LockfreeQueue per
+// producer. Producers register once and from then on only touch their own
+// shard, so a push costs the same as on an SPSC ring. The consumer finds work
+// through an occupancy bitmap: a producer sets its bit after pushing to an
+// empty-looking shard and the consumer clears it when it drains the shard, so
+// idle shards are skipped a word at a time.
+//
+// Clearing a bit races with a concurrent push. The consumer clears the bit
+// and then re-checks the shard, the producer pushes and then checks the bit;
+// both sides use sequentially consistent operations, so at least one of them
+// notices the other and a non-empty shard never stays unmarked.
+//
+// Elements from one producer come out in the order they were pushed; there is
+// no order between producers.
+template <typename T, class Allocator = std::allocator<T>>
+class FanInQueue {
+public:
+  class Producer;
+
+  explicit FanInQueue(size_t max_producers, size_t shard_capacity = DEFAULT_CAPACITY,
+      const Allocator& alloca = Allocator());
+  FanInQueue(const FanInQueue&) = delete;
+  FanInQueue& operator=(const FanInQueue&) = delete;
+
+  Producer register_producer();
+
+  bool try_pop(T& value);
+  template <class Consumer>
+  size_t drain(Consumer consume, size_t batch = DEFAULT_BATCH,
+      DrainPolicy policy = DrainPolicy::RoundRobin);
+
+  size_t producers() const;
+  size_t max_producers() const;
+  size_t size() const;
+  bool empty() const;
+
+private:
+  struct Shard {
+    LockfreeQueue<T, Allocator> queue;
+
+    Shard(size_t capacity, const Allocator& alloca) : queue(capacity, alloca) {}
+  };
+
+  static const size_t DEFAULT_CAPACITY = 1024;
+  static const size_t DEFAULT_BATCH = 64;
+  // Shards start on their own cache line so that producers never share one.
+  CacheAlignedArray<Shard> shards_;
+  size_t max_producers_;
+  std::atomic<size_t> producers_;
+  OccupancyBitmap occupancy_;
+  size_t cursor_;
+  std::vector<std::pair<size_t, size_t>> order_;
+
+  Shard& shard(size_t index) const;
+  void pushed(size_t index);
+  void drained(size_t index);
+  template <class Consumer>
+  size_t drain_shard(size_t index, Consumer& consume, size_t batch);
+};
+
+// Handle a producer thread pushes through. It is tied to one shard and must
+// only be used by one thread at a time.
+template <typename T, class Allocator>
+class FanInQueue<T, Allocator>::Producer {
+public:
+  bool try_push(T value);
+  void push(T value);
+  size_t id() const;
+
+private:
+  FanInQueue* queue_;
+  size_t shard_;
+
+  Producer(FanInQueue* queue, size_t shard) : queue_(queue), shard_(shard) {}
+
+  friend class FanInQueue;
+};
+
+template <typename T, class Allocator>
+FanInQueue<T, Allocator>::FanInQueue(size_t max_producers, size_t shard_capacity,
+    const Allocator& alloca)
+    : shards_(max_producers), max_producers_(max_producers), producers_(0),
+      occupancy_(max_producers), cursor_(0) {
+  for (size_t i = 0; i < max_producers_; i++) {
+    shards_.emplace_back(shard_capacity, alloca);
+  }
+  order_.reserve(max_producers_);
+}
+
+// Safe to call from any thread. Shards are never handed out twice, so a
+// queue supports at most max_producers registrations over its lifetime.
+template <typename T, class Allocator>
+typename FanInQueue<T, Allocator>::Producer FanInQueue<T, Allocator>::register_producer() {
+  size_t index = producers_.load();
+  do {
+    if (index >= max_producers_) {
+      throw std::length_error("FanInQueue: all " + std::to_string(max_producers_)
+          + " producer shards are taken");
+    }
+  } while (!producers_.compare_exchange_weak(index, index + 1));
+  return Producer(this, index);
+}
+
+template <typename T, class Allocator>
+bool FanInQueue<T, Allocator>::try_pop(T& value) {
+  size_t start = cursor_;
+  bool wrapped = false;
+  size_t index = occupancy_.next(start);
+  while (true) {
+    if (index == max_producers_) {
+      if (wrapped || start == 0) {
+        return false;
+      }
+      wrapped = true;
+      index = occupancy_.next(0);
+      continue;
+    }
+    if (wrapped && index >= start) {
+      return false;
+    }
+    // A bit can briefly stay set on a shard that was just emptied, when the
+    // producer's set lands after the consumer's re-check.
+    LockfreeQueue<T, Allocator>& queue = shard(index).queue;
+    if (!queue.empty()) {
+      value = std::move(queue.front());
+      queue.pop_front();
+      if (queue.empty()) {
+        drained(index);
+      }
+      cursor_ = index + 1;
+      return true;
+    }
+    drained(index);
+    index = occupancy_.next(index + 1);
+  }
+}
+
+// Hands up to `batch` elements from every occupied shard to
+// `consume(T&)` and returns how many were consumed. Only the consumer thread
+// may call it.
+template <typename T, class Allocator>
+template <class Consumer>
+size_t FanInQueue<T, Allocator>::drain(Consumer consume, size_t batch, DrainPolicy policy) {
+  size_t count = 0;
+  if (policy == DrainPolicy::LongestFirst) {
+    order_.clear();
+    for (size_t i = occupancy_.next(0); i < max_producers_; i = occupancy_.next(i + 1)) {
+      order_.push_back(std::make_pair(shard(i).queue.size(), i));
+    }
+    std::sort(order_.begin(), order_.end(), std::greater<std::pair<size_t, size_t>>());
+    for (const std::pair<size_t, size_t>& entry : order_) {
+      count += drain_shard(entry.second, consume, batch);
+    }
+    return count;
+  }
+
+  size_t start = cursor_;
+  bool wrapped = false;
+  size_t index = occupancy_.next(start);
+  while (true) {
+    if (index == max_producers_) {
+      if (wrapped || start == 0) {
+        break;
+      }
+      wrapped = true;
+      index = occupancy_.next(0);
+      continue;
+    }
+    if (wrapped && index >= start) {
+      break;
+    }
+    count += drain_shard(index, consume, batch);
+    cursor_ = index + 1;
+    index = occupancy_.next(index + 1);
+  }
+  return count;
+}
+
+template <typename T, class Allocator>
+size_t FanInQueue<T, Allocator>::producers() const {
+  return producers_.load();
+}
+
+template <typename T, class Allocator>
+size_t FanInQueue<T, Allocator>::max_producers() const {
+  return max_producers_;
+}
+
+template <typename T, class Allocator>
+size_t FanInQueue<T, Allocator>::size() const {
+  size_t size = 0;
+  for (size_t i = occupancy_.next(0); i < max_producers_; i = occupancy_.next(i + 1)) {
+    size += shard(i).queue.size();
+  }
+  return size;
+}
+
+template <typename T, class Allocator>
+bool FanInQueue<T, Allocator>::empty() const {
+  return !occupancy_.any();
+}
+
+template <typename T, class Allocator>
+typename FanInQueue<T, Allocator>::Shard& FanInQueue<T, Allocator>::shard(size_t index) const {
+  return shards_[index];
+}
+
+template <typename T, class Allocator>
+void FanInQueue<T, Allocator>::pushed(size_t index) {
+  if (!occupancy_.test(index)) {
+    occupancy_.set(index);
+  }
+}
+
+template <typename T, class Allocator>
+void FanInQueue<T, Allocator>::drained(size_t index) {
+  occupancy_.clear(index);
+  if (!shard(index).queue.empty()) {
+    occupancy_.set(index);
+  }
+}
+
+template <typename T, class Allocator>
+template <class Consumer>
+size_t FanInQueue<T, Allocator>::drain_shard(size_t index, Consumer& consume, size_t batch) {
+  LockfreeQueue<T, Allocator>& queue = shard(index).queue;
+  size_t count = std::min(queue.size(), batch);
+  for (size_t i = 0; i < count; i++) {
+    consume(queue.front());
+    queue.pop_front();
+  }
+  if (queue.empty()) {
+    drained(index);
+  }
+  return count;
+}
+
+template <typename T, class Allocator>
+bool FanInQueue<T, Allocator>::Producer::try_push(T value) {
+  LockfreeQueue<T, Allocator>& queue = queue_->shard(shard_).queue;
+  if (queue.full()) {
+    return false;
+  }
+  queue.push_back(std::move(value));
+  queue_->pushed(shard_);
+  return true;
+}
+
+// Spins, yielding, while the shard is full.
+template <typename T, class Allocator>
+void FanInQueue<T, Allocator>::Producer::push(T value) {
+  LockfreeQueue<T, Allocator>& queue = queue_->shard(shard_).queue;
+  while (queue.full()) {
+    std::this_thread::yield();
+  }
+  queue.push_back(std::move(value));
+  queue_->pushed(shard_);
+}
+
+template <typename T, class Allocator>
+size_t FanInQueue<T, Allocator>::Producer::id() const {
+  return shard_;
+}
+}
+#endif
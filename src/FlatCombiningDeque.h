@@ -0,0 +1,268 @@
+#ifndef _FDT_FLAT_COMBINING_DEQUE_H_
+#define _FDT_FLAT_COMBINING_DEQUE_H_
+
+#include "Deque.h"
+#include "Layout.h"
+
+#include <atomic>
+#include <cstdint>
+#include <exception>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <utility>
+
+namespace fdt {
+// Deque shared by many threads through flat combining. Each thread registers
+// once and gets a publication slot of its own. To run an operation it writes
+// the request into its slot and tries to take the combiner lock; whoever holds
+// the lock walks all slots and applies every pending request to the
+// underlying Deque in one go, then marks each done. Threads that did not get
+// the lock spin on their own slot. The deque and the lock are only touched by
+// the combiner, so under contention they stay in one core's cache and the
+// other threads only exchange their slot's cache line with it.
+//
+// Exceptions thrown while applying a request, such as std::bad_alloc on
+// growth, are handed back to the thread that posted it.
+template <typename T, class Allocator = std::allocator<T>>
+class FlatCombiningDeque {
+public:
+  class Handle;
+
+  explicit FlatCombiningDeque(size_t max_threads, size_t capacity = DEFAULT_CAPACITY,
+      const Allocator& alloca = Allocator());
+  FlatCombiningDeque(const FlatCombiningDeque&) = delete;
+  FlatCombiningDeque& operator=(const FlatCombiningDeque&) = delete;
+
+  Handle register_thread();
+
+  size_t size() const;
+  bool empty() const;
+  size_t max_threads() const;
+
+private:
+  enum class Operation { PushFront, PushBack, PopFront, PopBack };
+  enum class State : uint32_t { Idle, Pending, Done };
+
+  struct Slot {
+    std::atomic<State> state;
+    Operation operation;
+    T* values;
+    size_t count;
+    size_t result;
+    std::exception_ptr error;
+
+    Slot() : state(State::Idle), operation(Operation::PushBack), values(nullptr), count(0),
+        result(0) {}
+  };
+
+  static const size_t DEFAULT_CAPACITY = 64;
+  // Passes over the slots a combiner makes before handing the lock back.
+  static const int COMBINE_PASSES = 3;
+
+  Deque<T, Allocator> deque_;
+  CacheAlignedArray<Slot> slots_;
+  size_t max_threads_;
+  std::atomic<size_t> threads_;
+  alignas(64) std::atomic<bool> lock_;
+  std::atomic<size_t> size_;
+
+  Slot& slot(size_t index) const;
+  size_t run(size_t index, Operation operation, T* values, size_t count);
+  void combine();
+  void apply(Slot& slot);
+};
+
+// Handle a thread posts operations through. It is tied to one slot and must
+// only be used by one thread at a time.
+template <typename T, class Allocator>
+class FlatCombiningDeque<T, Allocator>::Handle {
+public:
+  void push_front(T value);
+  void push_back(T value);
+  bool try_pop_front(T& value);
+  bool try_pop_back(T& value);
+  // Bulk operations, applied in one step: `values` are pushed in order,
+  // and up to `count` elements are popped into `out` in the order they leave.
+  void push_back(T* values, size_t count);
+  size_t pop_front(T* out, size_t count);
+  size_t id() const;
+
+private:
+  FlatCombiningDeque* deque_;
+  size_t slot_;
+
+  Handle(FlatCombiningDeque* deque, size_t slot) : deque_(deque), slot_(slot) {}
+
+  friend class FlatCombiningDeque;
+};
+
+template <typename T, class Allocator>
+FlatCombiningDeque<T, Allocator>::FlatCombiningDeque(size_t max_threads, size_t capacity,
+    const Allocator& alloca)
+    : deque_(capacity, alloca), slots_(max_threads), max_threads_(max_threads), threads_(0),
+      lock_(false), size_(0) {
+  for (size_t i = 0; i < max_threads_; i++) {
+    slots_.emplace_back();
+  }
+}
+
+// Safe to call from any thread. Slots are never handed out twice, so a deque
+// supports at most max_threads registrations over its lifetime.
+template <typename T, class Allocator>
+typename FlatCombiningDeque<T, Allocator>::Handle FlatCombiningDeque<T, Allocator>::register_thread() {
+  size_t index = threads_.load();
+  do {
+    if (index >= max_threads_) {
+      throw std::length_error("FlatCombiningDeque: all " + std::to_string(max_threads_)
+          + " thread slots are taken");
+    }
+  } while (!threads_.compare_exchange_weak(index, index + 1));
+  return Handle(this, index);
+}
+
+template <typename T, class Allocator>
+size_t FlatCombiningDeque<T, Allocator>::size() const {
+  return size_.load(std::memory_order_relaxed);
+}
+
+template <typename T, class Allocator>
+bool FlatCombiningDeque<T, Allocator>::empty() const {
+  return size() == 0;
+}
+
+template <typename T, class Allocator>
+size_t FlatCombiningDeque<T, Allocator>::max_threads() const {
+  return max_threads_;
+}
+
+template <typename T, class Allocator>
+typename FlatCombiningDeque<T, Allocator>::Slot& FlatCombiningDeque<T, Allocator>::slot(
+    size_t index) const {
+  return slots_[index];
+}
+
+// Publishes a request and waits until some combiner, possibly this thread,
+// has applied it.
+template <typename T, class Allocator>
+size_t FlatCombiningDeque<T, Allocator>::run(size_t index, Operation operation, T* values,
+    size_t count) {
+  Slot& own = slot(index);
+  own.operation = operation;
+  own.values = values;
+  own.count = count;
+  own.state.store(State::Pending, std::memory_order_release);
+  int spins = 0;
+  while (own.state.load(std::memory_order_acquire) != State::Done) {
+    if (!lock_.load(std::memory_order_relaxed)
+        && !lock_.exchange(true, std::memory_order_acquire)) {
+      combine();
+      lock_.store(false, std::memory_order_release);
+    } else if (++spins == 64) {
+      spins = 0;
+      std::this_thread::yield();
+    }
+  }
+  own.state.store(State::Idle, std::memory_order_relaxed);
+  if (own.error) {
+    std::exception_ptr error = own.error;
+    own.error = nullptr;
+    std::rethrow_exception(error);
+  }
+  return own.result;
+}
+
+template <typename T, class Allocator>
+void FlatCombiningDeque<T, Allocator>::combine() {
+  size_t threads = threads_.load(std::memory_order_acquire);
+  for (int pass = 0; pass < COMBINE_PASSES; pass++) {
+    size_t applied = 0;
+    for (size_t i = 0; i < threads; i++) {
+      Slot& pending = slot(i);
+      if (pending.state.load(std::memory_order_acquire) == State::Pending) {
+        apply(pending);
+        pending.state.store(State::Done, std::memory_order_release);
+        applied++;
+      }
+    }
+    // Another pass only pays off while other threads keep posting; a pass
+    // that found just the combiner's own request means they are not.
+    if (applied <= 1) {
+      break;
+    }
+  }
+  size_.store(deque_.size(), std::memory_order_relaxed);
+}
+
+template <typename T, class Allocator>
+void FlatCombiningDeque<T, Allocator>::apply(Slot& request) {
+  try {
+    size_t done = 0;
+    switch (request.operation) {
+      case Operation::PushFront:
+        deque_.push_front(std::move(*request.values));
+        done = 1;
+        break;
+      case Operation::PushBack:
+        for (; done < request.count; done++) {
+          deque_.push_back(std::move(request.values[done]));
+        }
+        break;
+      case Operation::PopFront:
+        for (; done < request.count && !deque_.empty(); done++) {
+          request.values[done] = std::move(deque_.front());
+          deque_.pop_front();
+        }
+        break;
+      case Operation::PopBack:
+        if (!deque_.empty()) {
+          *request.values = std::move(deque_.back());
+          deque_.pop_back();
+          done = 1;
+        }
+        break;
+    }
+    request.result = done;
+  } catch (...) {
+    request.error = std::current_exception();
+  }
+}
+
+template <typename T, class Allocator>
+void FlatCombiningDeque<T, Allocator>::Handle::push_front(T value) {
+  deque_->run(slot_, Operation::PushFront, &value, 1);
+}
+
+template <typename T, class Allocator>
+void FlatCombiningDeque<T, Allocator>::Handle::push_back(T value) {
+  deque_->run(slot_, Operation::PushBack, &value, 1);
+}
+
+template <typename T, class Allocator>
+bool FlatCombiningDeque<T, Allocator>::Handle::try_pop_front(T& value) {
+  return deque_->run(slot_, Operation::PopFront, &value, 1) == 1;
+}
+
+template <typename T, class Allocator>
+bool FlatCombiningDeque<T, Allocator>::Handle::try_pop_back(T& value) {
+  return deque_->run(slot_, Operation::PopBack, &value, 1) == 1;
+}
+
+// Leaves `values` moved from.
+template <typename T, class Allocator>
+void FlatCombiningDeque<T, Allocator>::Handle::push_back(T* values, size_t count) {
+  deque_->run(slot_, Operation::PushBack, values, count);
+}
+
+template <typename T, class Allocator>
+size_t FlatCombiningDeque<T, Allocator>::Handle::pop_front(T* out, size_t count) {
+  return deque_->run(slot_, Operation::PopFront, out, count);
+}
+
+template <typename T, class Allocator>
+size_t FlatCombiningDeque<T, Allocator>::Handle::id() const {
+  return slot_;
+}
+}
+#endif
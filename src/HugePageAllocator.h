@@ -0,0 +1,201 @@
+#ifndef _FDT_HUGE_PAGE_ALLOCATOR_H_
+#define _FDT_HUGE_PAGE_ALLOCATOR_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <new>
+
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+namespace fdt {
+enum class HugePages {
+  None,         // regular 4 KiB pages
+  Transparent,  // 2 MiB aligned mapping plus MADV_HUGEPAGE
+  Explicit      // MAP_HUGETLB from the reserved pool, Transparent if it is empty
+};
+
+struct HugePageOptions {
+  static const int ANY_NODE = -1;
+  static const int LOCAL_NODE = -2;
+
+  HugePages huge_pages = HugePages::Transparent;
+  // NUMA node the pages are bound to. LOCAL_NODE binds to the node of the
+  // thread calling allocate(), so a consumer thread that builds (or reserves)
+  // its ring gets node-local memory.
+  int node = ANY_NODE;
+  // Touch every page up front so that no fault lands on the hot path.
+  bool prefault = false;
+  // mlock the mapping. Limited by RLIMIT_MEMLOCK.
+  bool lock = false;
+};
+
+// Linux storage allocator for large rings. Every allocation is its own mmap,
+// rounded up to the page size, or to 2 MiB whenever huge pages are requested
+// so that deallocate() can recompute the exact mapping length. Huge pages,
+// node binding and locking are best effort: a request the kernel refuses
+// (empty hugetlbfs pool, THP disabled, unknown node, memlock limit) leaves
+// ordinary pages behind instead of failing. Only a failing mmap throws
+// std::bad_alloc.
+template <typename T>
+class HugePageAllocator {
+public:
+  typedef T value_type;
+
+  template <typename U>
+  struct rebind {
+    typedef HugePageAllocator<U> other;
+  };
+
+  HugePageAllocator();
+  explicit HugePageAllocator(const HugePageOptions& options);
+  template <typename U>
+  HugePageAllocator(const HugePageAllocator<U>& alloca);
+
+  T* allocate(size_t n);
+  void deallocate(T* p, size_t n);
+
+  const HugePageOptions& options() const;
+
+  static int current_node();
+
+  static const size_t BASE_PAGE_SIZE = 4096;
+  static const size_t HUGE_PAGE_SIZE = 2 * 1024 * 1024;
+
+private:
+  HugePageOptions options_;
+
+  static const int MPOL_BIND_MODE = 2;
+  static const size_t MAX_NODES = 1024;
+
+  size_t mapping_length(size_t n) const;
+  void* map_aligned(size_t length) const;
+  void bind(void* address, size_t length, int node) const;
+
+  template <typename> friend class HugePageAllocator;
+};
+
+template <typename T>
+HugePageAllocator<T>::HugePageAllocator() {}
+
+template <typename T>
+HugePageAllocator<T>::HugePageAllocator(const HugePageOptions& options)
+    : options_(options) {}
+
+template <typename T>
+template <typename U>
+HugePageAllocator<T>::HugePageAllocator(const HugePageAllocator<U>& alloca)
+    : options_(alloca.options_) {}
+
+template <typename T>
+T* HugePageAllocator<T>::allocate(size_t n) {
+  size_t length = mapping_length(n);
+  void* address = MAP_FAILED;
+  if (options_.huge_pages == HugePages::Explicit) {
+    address = mmap(nullptr, length, PROT_READ | PROT_WRITE,
+        MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+  }
+  if (address == MAP_FAILED) {
+    address = options_.huge_pages == HugePages::None
+      ? mmap(nullptr, length, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0)
+      : map_aligned(length);
+    if (address == MAP_FAILED) {
+      throw std::bad_alloc();
+    }
+    if (options_.huge_pages != HugePages::None) {
+      madvise(address, length, MADV_HUGEPAGE);
+    }
+  }
+
+  int node = options_.node == HugePageOptions::LOCAL_NODE ? current_node() : options_.node;
+  if (node >= 0) {
+    bind(address, length, node);
+  }
+  if (options_.prefault) {
+    volatile char* bytes = static_cast<volatile char*>(address);
+    for (size_t i = 0; i < length; i += BASE_PAGE_SIZE) {
+      bytes[i] = 0;
+    }
+  }
+  if (options_.lock) {
+    mlock(address, length);
+  }
+  return static_cast<T*>(address);
+}
+
+template <typename T>
+void HugePageAllocator<T>::deallocate(T* p, size_t n) {
+  if (p != nullptr) {
+    munmap(p, mapping_length(n));
+  }
+}
+
+template <typename T>
+const HugePageOptions& HugePageAllocator<T>::options() const {
+  return options_;
+}
+
+template <typename T>
+int HugePageAllocator<T>::current_node() {
+  unsigned cpu = 0;
+  unsigned node = 0;
+  if (syscall(SYS_getcpu, &cpu, &node, nullptr) != 0) {
+    return HugePageOptions::ANY_NODE;
+  }
+  return (int) node;
+}
+
+template <typename T>
+size_t HugePageAllocator<T>::mapping_length(size_t n) const {
+  size_t granularity = options_.huge_pages == HugePages::None ? BASE_PAGE_SIZE : HUGE_PAGE_SIZE;
+  size_t bytes = n == 0 ? 1 : n * sizeof(T);
+  return (bytes + granularity - 1) / granularity * granularity;
+}
+
+// Transparent huge pages are only used for 2 MiB aligned ranges, which a
+// plain mmap does not promise. Map one huge page more and trim both ends.
+template <typename T>
+void* HugePageAllocator<T>::map_aligned(size_t length) const {
+  size_t padded = length + HUGE_PAGE_SIZE;
+  void* address = mmap(nullptr, padded, PROT_READ | PROT_WRITE,
+      MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+  if (address == MAP_FAILED) {
+    return address;
+  }
+  uintptr_t start = reinterpret_cast<uintptr_t>(address);
+  uintptr_t aligned = (start + HUGE_PAGE_SIZE - 1) & ~(uintptr_t) (HUGE_PAGE_SIZE - 1);
+  if (aligned > start) {
+    munmap(address, aligned - start);
+  }
+  size_t tail = padded - (aligned - start) - length;
+  if (tail > 0) {
+    munmap(reinterpret_cast<void*>(aligned + length), tail);
+  }
+  return reinterpret_cast<void*>(aligned);
+}
+
+// Raw system call so that libnuma is not a dependency. The pages are not yet
+// touched, so the policy decides where every one of them lands.
+template <typename T>
+void HugePageAllocator<T>::bind(void* address, size_t length, int node) const {
+  if ((size_t) node >= MAX_NODES) {
+    return;
+  }
+  const size_t bits = 8 * sizeof(unsigned long);
+  unsigned long mask[MAX_NODES / (8 * sizeof(unsigned long))] = {};
+  mask[node / bits] = 1UL << (node % bits);
+  syscall(SYS_mbind, address, length, MPOL_BIND_MODE, mask, MAX_NODES + 1, 0);
+}
+
+template <typename T, typename U>
+bool operator==(const HugePageAllocator<T>& a, const HugePageAllocator<U>& b) {
+  return a.options().huge_pages == b.options().huge_pages;
+}
+
+template <typename T, typename U>
+bool operator!=(const HugePageAllocator<T>& a, const HugePageAllocator<U>& b) {
+  return !(a == b);
+}
+}
+#endif
@@ -0,0 +1,103 @@
+#ifndef _FDT_LAYOUT_H_
+#define _FDT_LAYOUT_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <new>
+#include <utility>
+
+namespace fdt {
+// Smallest power of two that is at least n, and 1 for n == 0. Rings sized
+// this way map positions to slots with a mask.
+inline size_t round_up_pow2(size_t n) {
+  size_t rounded = 1;
+  while (rounded < n) {
+    rounded *= 2;
+  }
+  return rounded;
+}
+
+// Fixed-capacity array whose elements each start on a cache line of their
+// own, so that threads working on neighbouring elements never share a line.
+// Elements are constructed in order with emplace_back() and destroyed with
+// the array; none is ever removed, so pointers to them stay valid for the
+// array's lifetime, including across moves of the array itself.
+template <typename T>
+class CacheAlignedArray {
+public:
+  static const size_t CACHE_LINE = 64;
+  static const size_t STRIDE = (sizeof(T) + CACHE_LINE - 1) / CACHE_LINE * CACHE_LINE;
+
+  static_assert(alignof(T) <= CACHE_LINE,
+      "CacheAlignedArray: T must not need more than cache-line alignment");
+
+  explicit CacheAlignedArray(size_t capacity);
+  CacheAlignedArray(CacheAlignedArray&& other) noexcept;
+  CacheAlignedArray(const CacheAlignedArray&) = delete;
+  CacheAlignedArray& operator=(const CacheAlignedArray&) = delete;
+  ~CacheAlignedArray();
+
+  template <typename... Args>
+  T& emplace_back(Args&&... args);
+
+  T& operator[](size_t index) const;
+  size_t size() const;
+  size_t capacity() const;
+
+private:
+  void* storage_;
+  char* elements_;
+  size_t capacity_;
+  size_t size_;
+};
+
+template <typename T>
+CacheAlignedArray<T>::CacheAlignedArray(size_t capacity)
+    : storage_(::operator new(STRIDE * capacity + CACHE_LINE)), capacity_(capacity), size_(0) {
+  uintptr_t address = reinterpret_cast<uintptr_t>(storage_);
+  elements_ = reinterpret_cast<char*>((address + CACHE_LINE - 1) & ~(uintptr_t) (CACHE_LINE - 1));
+}
+
+template <typename T>
+CacheAlignedArray<T>::CacheAlignedArray(CacheAlignedArray&& other) noexcept
+    : storage_(other.storage_), elements_(other.elements_), capacity_(other.capacity_),
+      size_(other.size_) {
+  other.storage_ = nullptr;
+  other.elements_ = nullptr;
+  other.capacity_ = 0;
+  other.size_ = 0;
+}
+
+template <typename T>
+CacheAlignedArray<T>::~CacheAlignedArray() {
+  while (size_ > 0) {
+    operator[](--size_).~T();
+  }
+  ::operator delete(storage_);
+}
+
+// Constructs the next element. The array must not be full.
+template <typename T>
+template <typename... Args>
+T& CacheAlignedArray<T>::emplace_back(Args&&... args) {
+  T* element = new (elements_ + size_ * STRIDE) T(std::forward<Args>(args)...);
+  size_++;
+  return *element;
+}
+
+template <typename T>
+inline T& CacheAlignedArray<T>::operator[](size_t index) const {
+  return *reinterpret_cast<T*>(elements_ + index * STRIDE);
+}
+
+template <typename T>
+size_t CacheAlignedArray<T>::size() const {
+  return size_;
+}
+
+template <typename T>
+size_t CacheAlignedArray<T>::capacity() const {
+  return capacity_;
+}
+}
+#endif
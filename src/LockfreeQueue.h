@@ -2,6 +2,7 @@
 #define _FDT_DEQUE_LOCK_FREE_H_
 
 #include "DequeIterator.h"
+#include "Stats.h"
 
 #include <string>
 #include <ostream>
@@ -14,12 +15,12 @@
 
 namespace fdt {
 template<typename T> class DequeIterator;
-template<typename T,  class Allocator = std::allocator<T>>
-class LockfreeQueue {
+template<typename T,  class Allocator = std::allocator<T>, class Stats = NoStats>
+class LockfreeQueue : private Stats {
 public:
   LockfreeQueue();
   LockfreeQueue(size_t capacity, const Allocator& alloca = Allocator());
-  LockfreeQueue(const LockfreeQueue<T>& deque, const Allocator& alloca = Allocator());
+  LockfreeQueue(const LockfreeQueue& deque, const Allocator& alloca = Allocator());
   LockfreeQueue(std::initializer_list<T> container, const Allocator& alloca = Allocator());
   ~LockfreeQueue();
   LockfreeQueue& operator=(const LockfreeQueue& deque);
@@ -46,8 +47,7 @@ public:
   bool empty() const;
   std::string to_string() const;
 
-  template <typename U>
-  friend std::ostream& operator<<(std::ostream& out, const LockfreeQueue<U>& deque);
+  StatsSnapshot stats() const;
 
 private:
   T* container_;
@@ -65,17 +65,17 @@ private:
   void check_nonempty() const;
 };
 
-template <typename T, class Allocator> 
-LockfreeQueue<T, Allocator>::LockfreeQueue() : LockfreeQueue(DEFAULT_CAPACITY) {}
+template <typename T, class Allocator, class Stats> 
+LockfreeQueue<T, Allocator, Stats>::LockfreeQueue() : LockfreeQueue(DEFAULT_CAPACITY) {}
 
-template <typename T, class Allocator> 
-LockfreeQueue<T, Allocator>::LockfreeQueue(size_t capacity, const Allocator& alloca)
+template <typename T, class Allocator, class Stats> 
+LockfreeQueue<T, Allocator, Stats>::LockfreeQueue(size_t capacity, const Allocator& alloca)
     : alloca_(alloca), capacity_(capacity), size_(0), front_(0), tail_(0) {
   container_ = alloca_.allocate(capacity_);
 }
 
-template <typename T, class Allocator> 
-LockfreeQueue<T, Allocator>::LockfreeQueue(const LockfreeQueue<T>& deque, const Allocator& alloca)
+template <typename T, class Allocator, class Stats> 
+LockfreeQueue<T, Allocator, Stats>::LockfreeQueue(const LockfreeQueue& deque, const Allocator& alloca)
     : LockfreeQueue(deque.capacity_, alloca) {
   size_t i = 0;
   for (const T& value : deque) {
@@ -85,8 +85,8 @@ LockfreeQueue<T, Allocator>::LockfreeQueue(const LockfreeQueue<T>& deque, const
   tail_.store(deque.size);
 }
 
-template <typename T, class Allocator> 
-LockfreeQueue<T, Allocator>::LockfreeQueue(std::initializer_list<T> container, const Allocator &alloca)
+template <typename T, class Allocator, class Stats> 
+LockfreeQueue<T, Allocator, Stats>::LockfreeQueue(std::initializer_list<T> container, const Allocator &alloca)
     : LockfreeQueue(container.size() * 2, alloca) {
   size_t i = 0;
   for (const T& value : container) {
@@ -96,13 +96,13 @@ LockfreeQueue<T, Allocator>::LockfreeQueue(std::initializer_list<T> container, c
   tail_.store(container.size());
 }
 
-template <typename T, class Allocator> 
-LockfreeQueue<T, Allocator>::~LockfreeQueue() {
+template <typename T, class Allocator, class Stats> 
+LockfreeQueue<T, Allocator, Stats>::~LockfreeQueue() {
   alloca_.deallocate(container_, capacity_);
 }
 
-template <typename T, class Allocator> 
-LockfreeQueue<T, Allocator>& LockfreeQueue<T, Allocator>::operator=(const LockfreeQueue<T, Allocator>& deque) {
+template <typename T, class Allocator, class Stats> 
+LockfreeQueue<T, Allocator, Stats>& LockfreeQueue<T, Allocator, Stats>::operator=(const LockfreeQueue<T, Allocator, Stats>& deque) {
   size_.store(deque.size_.load());
   tail_.store(deque.size);
   front_.store(0);
@@ -119,8 +119,8 @@ LockfreeQueue<T, Allocator>& LockfreeQueue<T, Allocator>::operator=(const Lockfr
   return *this;
 }
 
-template <typename T, class Allocator> 
-LockfreeQueue<T, Allocator>& LockfreeQueue<T, Allocator>::operator=(std::initializer_list<T> container) {
+template <typename T, class Allocator, class Stats> 
+LockfreeQueue<T, Allocator, Stats>& LockfreeQueue<T, Allocator, Stats>::operator=(std::initializer_list<T> container) {
   size_.store(container.size());
   tail_.store(container.size);
   front_.store(0);
@@ -136,27 +136,29 @@ LockfreeQueue<T, Allocator>& LockfreeQueue<T, Allocator>::operator=(std::initial
   return *this;
 }
 
-template <typename T, class Allocator> 
-void LockfreeQueue<T, Allocator>::push_back(T value) {
+template <typename T, class Allocator, class Stats> 
+void LockfreeQueue<T, Allocator, Stats>::push_back(T value) {
   int tmpTL = tail_.fetch_add(1);
   container_[tmpTL] = value;
   tail_.store(tail_.load() % capacity_);
-  size_.fetch_add(1);
+  Stats::on_push(size_.fetch_add(1) + 1);
 }
 
-template <typename T, class Allocator> 
-void LockfreeQueue<T, Allocator>::pop_front() {
+template <typename T, class Allocator, class Stats> 
+void LockfreeQueue<T, Allocator, Stats>::pop_front() {
   check_nonempty();
   front_.fetch_add(1);
   front_.store(front_.load() % capacity_); 
   size_.fetch_add(-1);
+  Stats::on_pop();
 }
 
-template <typename T, class Allocator> 
-void LockfreeQueue<T, Allocator>::reserve(size_t capacity) {
+template <typename T, class Allocator, class Stats> 
+void LockfreeQueue<T, Allocator, Stats>::reserve(size_t capacity) {
   if (capacity <= capacity_) {
     return;
   }
+  Stats::on_reserve(size_.load() * sizeof(T));
   T* new_container = alloca_.allocate(capacity);
   for (size_t i = 0; i < size_.load(); i++) {
     new_container[i] = container_[(i + front_) % capacity_];
@@ -167,74 +169,78 @@ void LockfreeQueue<T, Allocator>::reserve(size_t capacity) {
   front_.store(0);
 }
 
-template <typename T, class Allocator> 
-void LockfreeQueue<T, Allocator>::clear() {
+template <typename T, class Allocator, class Stats> 
+void LockfreeQueue<T, Allocator, Stats>::clear() {
   size_.store(0);
   front_.store(0);
   tail_.store(0);
 }
 
-template <typename T, class Allocator> 
-T& LockfreeQueue<T, Allocator>::front() {
+template <typename T, class Allocator, class Stats> 
+T& LockfreeQueue<T, Allocator, Stats>::front() {
   check_nonempty();
   return container_[front_.load()];
 }
 
-template <typename T, class Allocator> 
-T& LockfreeQueue<T, Allocator>::at(size_t index) {
+template <typename T, class Allocator, class Stats> 
+T& LockfreeQueue<T, Allocator, Stats>::at(size_t index) {
   if (index >= size_) {
     out_of_range("index", index, ">=", "this->size()", size_);
   }
   return operator[](index);
 }
 
-template <typename T, class Allocator> 
-T& LockfreeQueue<T, Allocator>::operator[](size_t index) {
+template <typename T, class Allocator, class Stats> 
+T& LockfreeQueue<T, Allocator, Stats>::operator[](size_t index) {
   return container_[(front_.load() + index) % capacity_];
 }
 
-template <typename T, class Allocator> 
-T LockfreeQueue<T, Allocator>::front() const {
+template <typename T, class Allocator, class Stats> 
+T LockfreeQueue<T, Allocator, Stats>::front() const {
   return front();
 }
 
-template <typename T, class Allocator> 
-T LockfreeQueue<T, Allocator>::at(size_t index) const {
+template <typename T, class Allocator, class Stats> 
+T LockfreeQueue<T, Allocator, Stats>::at(size_t index) const {
   return at(index);
 }
 
-template <typename T, class Allocator> 
-T LockfreeQueue<T, Allocator>::operator[](size_t index) const {
+template <typename T, class Allocator, class Stats> 
+T LockfreeQueue<T, Allocator, Stats>::operator[](size_t index) const {
   return operator[](index);
 }
 
-template <typename T, class Allocator> 
-DequeIterator<T> LockfreeQueue<T,  Allocator>::begin() const {
+template <typename T, class Allocator, class Stats> 
+DequeIterator<T> LockfreeQueue<T, Allocator, Stats>::begin() const {
   return DequeIterator<T>(container_, capacity_, size_, front_, 0);
 }
 
-template <typename T, class Allocator> 
-DequeIterator<T> LockfreeQueue<T, Allocator>::end() const {
+template <typename T, class Allocator, class Stats> 
+DequeIterator<T> LockfreeQueue<T, Allocator, Stats>::end() const {
   return DequeIterator<T>(container_, capacity_, size_, front_, size_);
 }
 
-template <typename T, class Allocator> 
-size_t LockfreeQueue<T, Allocator>::capacity() const {
+template <typename T, class Allocator, class Stats> 
+size_t LockfreeQueue<T, Allocator, Stats>::capacity() const {
   return capacity_;
 }
 
-template <typename T, class Allocator> 
-size_t LockfreeQueue<T, Allocator>::size() const {
+template <typename T, class Allocator, class Stats> 
+size_t LockfreeQueue<T, Allocator, Stats>::size() const {
   return size_.load();
 }
 
-template <typename T, class Allocator> 
-bool LockfreeQueue<T, Allocator>::empty() const {
-  return size_.load() == 0;
+template <typename T, class Allocator, class Stats> 
+bool LockfreeQueue<T, Allocator, Stats>::empty() const {
+  if (size_.load() != 0) {
+    return false;
+  }
+  Stats::on_empty();
+  return true;
 }
 
-template <typename T, class Allocator>
-std::string LockfreeQueue<T, Allocator>::to_string() const {
+template <typename T, class Allocator, class Stats>
+std::string LockfreeQueue<T, Allocator, Stats>::to_string() const {
   std::ostringstream out;
   size_t cur = front_.load();
   size_t end = front_.load() + size_.load();
@@ -248,15 +254,20 @@ std::string LockfreeQueue<T, Allocator>::to_string() const {
   return out.str();
 }
 
-template <typename T> 
+template <typename T, class Allocator, class Stats>
+StatsSnapshot LockfreeQueue<T, Allocator, Stats>::stats() const {
+  return Stats::snapshot();
+}
+
+template <typename T, class Allocator, class Stats>
 std::ostream& operator<<(std::ostream& out,
-    const LockfreeQueue<T>& deque) {
+    const LockfreeQueue<T, Allocator, Stats>& deque) {
   return out << deque.to_string();
 }
 
 
-template <typename T, class Allocator> 
-void LockfreeQueue<T, Allocator>::out_of_range(const char* id_1, size_t value_1,
+template <typename T, class Allocator, class Stats> 
+void LockfreeQueue<T, Allocator, Stats>::out_of_range(const char* id_1, size_t value_1,
     const char* op, const char* id_2, size_t value_2) const {
   std::ostringstream out;
   out << "Deque: " << id_1 << " (which is " << value_1 << ") "
@@ -265,16 +276,20 @@ void LockfreeQueue<T, Allocator>::out_of_range(const char* id_1, size_t value_1,
   // throw std::out_of_range(out.str());
 }
 
-template <typename T, class Allocator> 
-void LockfreeQueue<T, Allocator>::check_nonempty() const {
+template <typename T, class Allocator, class Stats> 
+void LockfreeQueue<T, Allocator, Stats>::check_nonempty() const {
   if (size_.load() == 0) {
     throw std::out_of_range("Deque: cannot access element in empty deque");
   }
 }
 
-template <typename T, class Allocator> 
-bool LockfreeQueue<T, Allocator>::full() const{
-  return size_.load() == capacity_;
+template <typename T, class Allocator, class Stats> 
+bool LockfreeQueue<T, Allocator, Stats>::full() const{
+  if (size_.load() != capacity_) {
+    return false;
+  }
+  Stats::on_full();
+  return true;
 }
 
 }
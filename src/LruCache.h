@@ -0,0 +1,322 @@
+#ifndef _FDT_LRU_CACHE_H_
+#define _FDT_LRU_CACHE_H_
+
+#include "Deque.h"
+#include "Layout.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <functional>
+#include <utility>
+#include <vector>
+
+namespace fdt {
+enum class EvictionPolicy {
+  LRU,  // get() and put() of an existing key make it the newest entry
+  FIFO  // entries leave in insertion order whatever is read
+};
+
+// Bounded key-value cache. Entries live in a Deque in recency order, oldest
+// at the front, and each one is known by a sequence number that never
+// changes: its index in the deque plus the number of entries ever popped from
+// the front. A flat open-addressing table maps keys to sequence numbers, so a
+// lookup is one probe sequence over an array of (hash, sequence) pairs and one
+// access to the deque.
+//
+// Promoting or erasing an entry in the middle does not shift the deque: the
+// old slot is marked dead and, for a promotion, the entry is appended again.
+// Dead slots are dropped when they reach the front, and the deque is
+// compacted once it is more than twice the capacity long, so every operation
+// is amortized O(1).
+template <typename K, typename V, class Hash = std::hash<K>, class KeyEqual = std::equal_to<K>>
+class LruCache {
+public:
+  explicit LruCache(size_t capacity, EvictionPolicy policy = EvictionPolicy::LRU);
+
+  V* get(const K& key);
+  void put(const K& key, V value);
+  bool promote(const K& key);
+  bool erase(const K& key);
+  bool evict();
+  bool contains(const K& key) const;
+  void clear();
+
+  size_t capacity() const;
+  size_t size() const;
+  bool empty() const;
+  EvictionPolicy policy() const;
+
+private:
+  struct Entry {
+    K key;
+    V value;
+    bool live;
+  };
+
+  struct Slot {
+    uint64_t sequence;
+    size_t hash;
+  };
+
+  static const uint64_t EMPTY = ~uint64_t(0);
+  static const uint64_t TOMBSTONE = ~uint64_t(0) - 1;
+  static const size_t NOT_FOUND = ~size_t(0);
+
+  Deque<Entry> entries_;
+  std::vector<Slot> index_;
+  size_t mask_;
+  size_t capacity_;
+  size_t size_;
+  size_t used_slots_;
+  uint64_t base_;
+  EvictionPolicy policy_;
+  Hash hash_;
+  KeyEqual equal_;
+
+  size_t find(const K& key, size_t hash) const;
+  void insert_slot(uint64_t sequence, size_t hash);
+  Entry& entry(uint64_t sequence);
+  const Entry& entry(uint64_t sequence) const;
+  void append(const K& key, V value, size_t slot);
+  void kill(size_t slot);
+  void trim();
+  void compact();
+  void rebuild_index();
+};
+
+template <typename K, typename V, class Hash, class KeyEqual>
+LruCache<K, V, Hash, KeyEqual>::LruCache(size_t capacity, EvictionPolicy policy)
+    : entries_(2 * (capacity + 1) + 1), capacity_(capacity), size_(0), used_slots_(0),
+      base_(0), policy_(policy) {
+  size_t slots = std::max<size_t>(8, round_up_pow2(2 * capacity));
+  index_.assign(slots, Slot{EMPTY, 0});
+  mask_ = slots - 1;
+}
+
+// Returns the cached value, or nullptr. The pointer is valid until the next
+// call that changes the cache.
+template <typename K, typename V, class Hash, class KeyEqual>
+V* LruCache<K, V, Hash, KeyEqual>::get(const K& key) {
+  size_t slot = find(key, hash_(key));
+  if (slot == NOT_FOUND) {
+    return nullptr;
+  }
+  if (policy_ == EvictionPolicy::FIFO) {
+    return &entry(index_[slot].sequence).value;
+  }
+  if (index_[slot].sequence != base_ + entries_.size() - 1) {
+    Entry& old = entry(index_[slot].sequence);
+    append(old.key, std::move(old.value), slot);
+  }
+  return &entries_.back().value;
+}
+
+template <typename K, typename V, class Hash, class KeyEqual>
+void LruCache<K, V, Hash, KeyEqual>::put(const K& key, V value) {
+  if (capacity_ == 0) {
+    return;
+  }
+  size_t hash = hash_(key);
+  size_t slot = find(key, hash);
+  if (slot != NOT_FOUND) {
+    Entry& old = entry(index_[slot].sequence);
+    if (policy_ == EvictionPolicy::LRU) {
+      append(old.key, std::move(value), slot);
+    } else {
+      old.value = std::move(value);
+    }
+    return;
+  }
+  if (size_ == capacity_) {
+    evict();
+  }
+  entries_.push_back(Entry{key, std::move(value), true});
+  insert_slot(base_ + entries_.size() - 1, hash);
+  size_++;
+  trim();
+}
+
+// Makes an entry the newest one regardless of the policy.
+template <typename K, typename V, class Hash, class KeyEqual>
+bool LruCache<K, V, Hash, KeyEqual>::promote(const K& key) {
+  size_t slot = find(key, hash_(key));
+  if (slot == NOT_FOUND) {
+    return false;
+  }
+  if (index_[slot].sequence != base_ + entries_.size() - 1) {
+    Entry& old = entry(index_[slot].sequence);
+    append(old.key, std::move(old.value), slot);
+  }
+  return true;
+}
+
+template <typename K, typename V, class Hash, class KeyEqual>
+bool LruCache<K, V, Hash, KeyEqual>::erase(const K& key) {
+  size_t slot = find(key, hash_(key));
+  if (slot == NOT_FOUND) {
+    return false;
+  }
+  kill(slot);
+  trim();
+  return true;
+}
+
+// Removes the oldest entry.
+template <typename K, typename V, class Hash, class KeyEqual>
+bool LruCache<K, V, Hash, KeyEqual>::evict() {
+  if (size_ == 0) {
+    return false;
+  }
+  Entry& oldest = entries_.front();
+  kill(find(oldest.key, hash_(oldest.key)));
+  trim();
+  return true;
+}
+
+template <typename K, typename V, class Hash, class KeyEqual>
+bool LruCache<K, V, Hash, KeyEqual>::contains(const K& key) const {
+  return find(key, hash_(key)) != NOT_FOUND;
+}
+
+template <typename K, typename V, class Hash, class KeyEqual>
+void LruCache<K, V, Hash, KeyEqual>::clear() {
+  while (!entries_.empty()) {
+    entries_.front() = Entry();
+    entries_.pop_front();
+  }
+  index_.assign(index_.size(), Slot{EMPTY, 0});
+  size_ = 0;
+  used_slots_ = 0;
+  base_ = 0;
+}
+
+template <typename K, typename V, class Hash, class KeyEqual>
+size_t LruCache<K, V, Hash, KeyEqual>::capacity() const {
+  return capacity_;
+}
+
+template <typename K, typename V, class Hash, class KeyEqual>
+size_t LruCache<K, V, Hash, KeyEqual>::size() const {
+  return size_;
+}
+
+template <typename K, typename V, class Hash, class KeyEqual>
+bool LruCache<K, V, Hash, KeyEqual>::empty() const {
+  return size_ == 0;
+}
+
+template <typename K, typename V, class Hash, class KeyEqual>
+EvictionPolicy LruCache<K, V, Hash, KeyEqual>::policy() const {
+  return policy_;
+}
+
+template <typename K, typename V, class Hash, class KeyEqual>
+size_t LruCache<K, V, Hash, KeyEqual>::find(const K& key, size_t hash) const {
+  for (size_t slot = hash & mask_;; slot = (slot + 1) & mask_) {
+    const Slot& candidate = index_[slot];
+    if (candidate.sequence == EMPTY) {
+      return NOT_FOUND;
+    }
+    if (candidate.sequence != TOMBSTONE && candidate.hash == hash
+        && equal_(entry(candidate.sequence).key, key)) {
+      return slot;
+    }
+  }
+}
+
+template <typename K, typename V, class Hash, class KeyEqual>
+void LruCache<K, V, Hash, KeyEqual>::insert_slot(uint64_t sequence, size_t hash) {
+  size_t slot = hash & mask_;
+  while (index_[slot].sequence != EMPTY && index_[slot].sequence != TOMBSTONE) {
+    slot = (slot + 1) & mask_;
+  }
+  if (index_[slot].sequence == EMPTY) {
+    used_slots_++;
+  }
+  index_[slot] = Slot{sequence, hash};
+  // Tombstones only go away on a rebuild; keep at least a quarter of the
+  // table empty so that misses stay short.
+  if (used_slots_ * 4 > index_.size() * 3) {
+    rebuild_index();
+  }
+}
+
+template <typename K, typename V, class Hash, class KeyEqual>
+typename LruCache<K, V, Hash, KeyEqual>::Entry& LruCache<K, V, Hash, KeyEqual>::entry(
+    uint64_t sequence) {
+  return entries_[sequence - base_];
+}
+
+// The const Deque accessors return copies; lookups only need the key.
+template <typename K, typename V, class Hash, class KeyEqual>
+const typename LruCache<K, V, Hash, KeyEqual>::Entry& LruCache<K, V, Hash, KeyEqual>::entry(
+    uint64_t sequence) const {
+  return const_cast<Deque<Entry>&>(entries_)[sequence - base_];
+}
+
+// Moves the entry indexed by `slot` to the back with `value`.
+template <typename K, typename V, class Hash, class KeyEqual>
+void LruCache<K, V, Hash, KeyEqual>::append(const K& key, V value, size_t slot) {
+  Entry& old = entry(index_[slot].sequence);
+  Entry moved{key, std::move(value), true};
+  old = Entry();
+  index_[slot].sequence = base_ + entries_.size();
+  entries_.push_back(std::move(moved));
+  trim();
+}
+
+template <typename K, typename V, class Hash, class KeyEqual>
+void LruCache<K, V, Hash, KeyEqual>::kill(size_t slot) {
+  entry(index_[slot].sequence) = Entry();
+  index_[slot].sequence = TOMBSTONE;
+  size_--;
+}
+
+// Drops dead slots at the front and compacts the deque once it is more than
+// twice the capacity long.
+template <typename K, typename V, class Hash, class KeyEqual>
+void LruCache<K, V, Hash, KeyEqual>::trim() {
+  while (!entries_.empty() && !entries_.front().live) {
+    entries_.pop_front();
+    base_++;
+  }
+  if (entries_.size() > 2 * capacity_) {
+    compact();
+  }
+}
+
+// Squeezes the dead slots out of the deque. Live entries keep their order
+// but get new sequence numbers, so the index is rebuilt as well.
+template <typename K, typename V, class Hash, class KeyEqual>
+void LruCache<K, V, Hash, KeyEqual>::compact() {
+  size_t count = entries_.size();
+  for (size_t i = 0; i < count; i++) {
+    // Taken out first: push_back may move the slot the front lives in.
+    Entry current = std::move(entries_.front());
+    entries_.front() = Entry();
+    entries_.pop_front();
+    if (current.live) {
+      entries_.push_back(std::move(current));
+    }
+  }
+  base_ = 0;
+  rebuild_index();
+}
+
+template <typename K, typename V, class Hash, class KeyEqual>
+void LruCache<K, V, Hash, KeyEqual>::rebuild_index() {
+  index_.assign(index_.size(), Slot{EMPTY, 0});
+  used_slots_ = 0;
+  for (size_t i = 0; i < entries_.size(); i++) {
+    if (entries_[i].live) {
+      size_t slot = hash_(entries_[i].key) & mask_;
+      while (index_[slot].sequence != EMPTY) {
+        slot = (slot + 1) & mask_;
+      }
+      index_[slot] = Slot{base_ + i, hash_(entries_[i].key)};
+      used_slots_++;
+    }
+  }
+}
+}
+#endif
@@ -0,0 +1,164 @@
+#ifndef _FDT_OBJECT_POOL_H_
+#define _FDT_OBJECT_POOL_H_
+
+#include "Layout.h"
+
+#include <algorithm>
+#include <atomic>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+namespace fdt {
+enum class PoolPolicy {
+  Grow,  // add a slab when no object is free, up to max_objects
+  Fail   // preallocate max_objects and return nullptr when none is free
+};
+
+// Pool of objects handed from one producer thread to one consumer thread,
+// such as messages sent through a LockfreeQueue. The producer acquires
+// objects and the consumer releases them when done; neither calls the
+// allocator once the pool has grown to its working size.
+//
+// The free list is split in two. Released objects go onto a return ring
+// that only the consumer writes, and the producer takes everything on it in
+// one go whenever its own stack of free objects runs empty, so the shared
+// ring index changes cache lines once per batch rather than per object. The
+// return ring has room for every object the pool may own, so it never fills
+// and releasing never waits. Objects live in slabs with each object on cache
+// lines of its own, so an object being filled by the producer never shares a
+// line with one the consumer is still reading.
+//
+// Objects are constructed with the slab and destroyed with the pool, not on
+// every acquire and release, so buffers they own are recycled with them.
+template <typename T>
+class ObjectPool {
+public:
+  explicit ObjectPool(size_t slab_objects = DEFAULT_SLAB_OBJECTS,
+      size_t max_objects = DEFAULT_MAX_OBJECTS, PoolPolicy policy = PoolPolicy::Grow);
+  ObjectPool(const ObjectPool&) = delete;
+  ObjectPool& operator=(const ObjectPool&) = delete;
+  ~ObjectPool();
+
+  // Producer side. Returns nullptr when the pool is exhausted.
+  T* acquire();
+  // Number of objects allocated so far.
+  size_t capacity() const;
+
+  // Consumer side.
+  void release(T* object);
+
+  size_t max_objects() const;
+  PoolPolicy policy() const;
+
+private:
+  static const size_t DEFAULT_SLAB_OBJECTS = 64;
+  static const size_t DEFAULT_MAX_OBJECTS = 4096;
+  std::vector<CacheAlignedArray<T>> slabs_;
+  std::vector<T*> free_;
+  T** returned_;
+  size_t return_mask_;
+  // Producer side: how many returned objects it has taken back so far.
+  size_t reclaimed_;
+  size_t slab_objects_;
+  size_t max_objects_;
+  size_t capacity_;
+  PoolPolicy policy_;
+  // Consumer side: how many objects it has returned so far.
+  alignas(64) std::atomic<size_t> released_;
+
+  void grow();
+  void reclaim();
+};
+
+template <typename T>
+ObjectPool<T>::ObjectPool(size_t slab_objects, size_t max_objects, PoolPolicy policy)
+    : returned_(nullptr), reclaimed_(0), slab_objects_(slab_objects), max_objects_(max_objects),
+      capacity_(0), policy_(policy), released_(0) {
+  if (slab_objects == 0 || max_objects == 0) {
+    throw std::invalid_argument("ObjectPool: slab_objects and max_objects must be positive");
+  }
+  if (policy_ == PoolPolicy::Fail) {
+    slab_objects_ = max_objects_;
+  }
+  size_t rounded = round_up_pow2(max_objects_);
+  free_.reserve(max_objects_);
+  returned_ = new T*[rounded];
+  return_mask_ = rounded - 1;
+  try {
+    grow();
+  } catch (...) {
+    delete[] returned_;
+    throw;
+  }
+}
+
+template <typename T>
+ObjectPool<T>::~ObjectPool() {
+  delete[] returned_;
+}
+
+// Hands out the most recently released object first, whose lines are the
+// likeliest to still be cached.
+template <typename T>
+T* ObjectPool<T>::acquire() {
+  if (free_.empty()) {
+    reclaim();
+    if (free_.empty()) {
+      if (policy_ == PoolPolicy::Fail || capacity_ == max_objects_) {
+        return nullptr;
+      }
+      grow();
+    }
+  }
+  T* object = free_.back();
+  free_.pop_back();
+  return object;
+}
+
+template <typename T>
+size_t ObjectPool<T>::capacity() const {
+  return capacity_;
+}
+
+template <typename T>
+void ObjectPool<T>::release(T* object) {
+  size_t released = released_.load(std::memory_order_relaxed);
+  returned_[released & return_mask_] = object;
+  released_.store(released + 1, std::memory_order_release);
+}
+
+template <typename T>
+size_t ObjectPool<T>::max_objects() const {
+  return max_objects_;
+}
+
+template <typename T>
+PoolPolicy ObjectPool<T>::policy() const {
+  return policy_;
+}
+
+template <typename T>
+void ObjectPool<T>::grow() {
+  size_t count = std::min(slab_objects_, max_objects_ - capacity_);
+  CacheAlignedArray<T> slab(count);
+  for (size_t i = 0; i < count; i++) {
+    slab.emplace_back();
+  }
+  slabs_.push_back(std::move(slab));
+  // Pushed in reverse so that the slab is handed out from its start.
+  for (size_t i = count; i > 0; i--) {
+    free_.push_back(&slabs_.back()[i - 1]);
+  }
+  capacity_ += count;
+}
+
+template <typename T>
+void ObjectPool<T>::reclaim() {
+  size_t released = released_.load(std::memory_order_acquire);
+  for (; reclaimed_ != released; reclaimed_++) {
+    free_.push_back(returned_[reclaimed_ & return_mask_]);
+  }
+}
+}
+#endif
@@ -0,0 +1,85 @@
+#ifndef _FDT_OCCUPANCY_BITMAP_H_
+#define _FDT_OCCUPANCY_BITMAP_H_
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+namespace fdt {
+// Fixed-size set of bits that any thread may set or clear. Scanning skips
+// whole zero words, so a consumer walking the set bits pays one load per 64
+// idle entries.
+class OccupancyBitmap {
+public:
+  explicit OccupancyBitmap(size_t bits);
+  OccupancyBitmap(const OccupancyBitmap&) = delete;
+  OccupancyBitmap& operator=(const OccupancyBitmap&) = delete;
+
+  void set(size_t bit);
+  void clear(size_t bit);
+  bool test(size_t bit) const;
+  bool any() const;
+  // Index of the first set bit at or after `from`, or size() if there is none.
+  size_t next(size_t from) const;
+
+  size_t size() const;
+
+private:
+  size_t bits_;
+  size_t words_;
+  std::unique_ptr<std::atomic<uint64_t>[]> data_;
+
+  static const size_t WORD_BITS = 64;
+};
+
+inline OccupancyBitmap::OccupancyBitmap(size_t bits)
+    : bits_(bits), words_((bits + WORD_BITS - 1) / WORD_BITS),
+      data_(new std::atomic<uint64_t>[words_]) {
+  for (size_t i = 0; i < words_; i++) {
+    data_[i].store(0, std::memory_order_relaxed);
+  }
+}
+
+inline void OccupancyBitmap::set(size_t bit) {
+  data_[bit / WORD_BITS].fetch_or(uint64_t(1) << (bit % WORD_BITS));
+}
+
+inline void OccupancyBitmap::clear(size_t bit) {
+  data_[bit / WORD_BITS].fetch_and(~(uint64_t(1) << (bit % WORD_BITS)));
+}
+
+inline bool OccupancyBitmap::test(size_t bit) const {
+  return (data_[bit / WORD_BITS].load() >> (bit % WORD_BITS)) & 1;
+}
+
+inline bool OccupancyBitmap::any() const {
+  for (size_t i = 0; i < words_; i++) {
+    if (data_[i].load(std::memory_order_relaxed) != 0) {
+      return true;
+    }
+  }
+  return false;
+}
+
+inline size_t OccupancyBitmap::next(size_t from) const {
+  if (from >= bits_) {
+    return bits_;
+  }
+  size_t word = from / WORD_BITS;
+  uint64_t value = data_[word].load() & (~uint64_t(0) << (from % WORD_BITS));
+  while (value == 0) {
+    if (++word == words_) {
+      return bits_;
+    }
+    value = data_[word].load();
+  }
+  size_t bit = word * WORD_BITS + __builtin_ctzll(value);
+  return bit < bits_ ? bit : bits_;
+}
+
+inline size_t OccupancyBitmap::size() const {
+  return bits_;
+}
+}
+#endif
@@ -0,0 +1,202 @@
+#ifndef _FDT_PARALLEL_ALGORITHMS_H_
+#define _FDT_PARALLEL_ALGORITHMS_H_
+
+#include "Deque.h"
+#include "Span.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <exception>
+#include <functional>
+#include <numeric>
+#include <thread>
+#include <vector>
+
+namespace fdt {
+// How a parallel algorithm splits its work. Below `threshold` elements, or
+// with a single thread, it runs serially on the calling thread.
+struct ParallelOptions {
+  size_t threads;
+  size_t threshold;
+
+  ParallelOptions()
+      : threads(std::max(std::thread::hardware_concurrency(), 1u)), threshold(1 << 16) {}
+};
+
+// Splits the elements into `parts` runs of consecutive elements. Each run is
+// described by up to two spans, since a run can straddle the point where the
+// deque wraps around its buffer. Cut points are moved forward to the next
+// cache line boundary so that no two threads write to the same line. When
+// `offsets` is given it receives the index of the first element of each run.
+template <typename T>
+std::vector<Segments<T>> partition(const Segments<T>& segments, size_t parts,
+    std::vector<size_t>* offsets = nullptr) {
+  const size_t CACHE_LINE = 64;
+  size_t size = segments.size();
+  std::vector<Segments<T>> runs;
+  size_t begin = 0;
+  for (size_t part = 1; part <= parts && begin < size; part++) {
+    size_t end = part == parts ? size : size / parts * part;
+    if (end < size && end > begin) {
+      T* cut = end < segments.first.size()
+        ? segments.first.data() + end
+        : segments.second.data() + (end - segments.first.size());
+      size_t misalign = reinterpret_cast<uintptr_t>(cut) % CACHE_LINE;
+      if (misalign % sizeof(T) == 0) {
+        end = std::min(size, end + (CACHE_LINE - misalign) % CACHE_LINE / sizeof(T));
+      }
+    }
+    if (end <= begin) {
+      continue;
+    }
+    Segments<T> run;
+    size_t first = segments.first.size();
+    if (begin < first) {
+      run.first = Span<T>(segments.first.data() + begin, std::min(end, first) - begin);
+    }
+    if (end > first) {
+      size_t from = std::max(begin, first) - first;
+      Span<T> wrapped(segments.second.data() + from, end - first - from);
+      if (run.first.empty()) {
+        run.first = wrapped;
+      } else {
+        run.second = wrapped;
+      }
+    }
+    runs.push_back(run);
+    if (offsets != nullptr) {
+      offsets->push_back(begin);
+    }
+    begin = end;
+  }
+  return runs;
+}
+
+// Runs body(0) .. body(count - 1) on count threads, one of them the caller,
+// and rethrows the first exception any of them threw.
+template <class Body>
+void run_parallel(size_t count, Body body) {
+  if (count == 0) {
+    return;
+  }
+  std::vector<std::exception_ptr> errors(count);
+  std::vector<std::thread> threads;
+  for (size_t i = 1; i < count; i++) {
+    threads.emplace_back([&body, &errors, i] {
+      try {
+        body(i);
+      } catch (...) {
+        errors[i] = std::current_exception();
+      }
+    });
+  }
+  try {
+    body(0);
+  } catch (...) {
+    errors[0] = std::current_exception();
+  }
+  for (std::thread& thread : threads) {
+    thread.join();
+  }
+  for (const std::exception_ptr& error : errors) {
+    if (error) {
+      std::rethrow_exception(error);
+    }
+  }
+}
+
+template <typename T, class Allocator, class Stats, class Function>
+void parallel_for_each(Deque<T, Allocator, Stats>& deque, Function f,
+    const ParallelOptions& options = ParallelOptions()) {
+  Segments<T> segments = deque.segments();
+  size_t parts = segments.size() < options.threshold ? 1 : options.threads;
+  std::vector<Segments<T>> runs = partition(segments, parts);
+  run_parallel(runs.size(), [&runs, &f](size_t i) {
+    std::for_each(runs[i].first.begin(), runs[i].first.end(), f);
+    std::for_each(runs[i].second.begin(), runs[i].second.end(), f);
+  });
+}
+
+// Resizes `out` to the size of `in` and writes op(in[i]) to out[i].
+template <typename T, class Allocator, class Stats, typename U, class OutAllocator,
+    class OutStats, class UnaryOperation>
+void parallel_transform(Deque<T, Allocator, Stats>& in, Deque<U, OutAllocator, OutStats>& out,
+    UnaryOperation op, const ParallelOptions& options = ParallelOptions()) {
+  out.resize(in.size());
+  U* result = out.linearize().data();
+  Segments<T> segments = in.segments();
+  size_t parts = segments.size() < options.threshold ? 1 : options.threads;
+  std::vector<size_t> offsets;
+  std::vector<Segments<T>> runs = partition(segments, parts, &offsets);
+  run_parallel(runs.size(), [&runs, &offsets, &op, result](size_t i) {
+    U* out = std::transform(runs[i].first.begin(), runs[i].first.end(), result + offsets[i], op);
+    std::transform(runs[i].second.begin(), runs[i].second.end(), out, op);
+  });
+}
+
+// Folds every run separately and then the partial results in order, so `op`
+// has to be associative; `init` is used once.
+template <typename T, class Allocator, class Stats, class BinaryOperation>
+T parallel_reduce(Deque<T, Allocator, Stats>& deque, T init, BinaryOperation op,
+    const ParallelOptions& options = ParallelOptions()) {
+  Segments<T> segments = deque.segments();
+  size_t parts = segments.size() < options.threshold ? 1 : options.threads;
+  std::vector<Segments<T>> runs = partition(segments, parts);
+  std::vector<T> partials(runs.size());
+  run_parallel(runs.size(), [&runs, &partials, &op](size_t i) {
+    const Segments<T>& run = runs[i];
+    T value = run.first[0];
+    value = std::accumulate(run.first.begin() + 1, run.first.end(), value, op);
+    partials[i] = std::accumulate(run.second.begin(), run.second.end(), value, op);
+  });
+  return std::accumulate(partials.begin(), partials.end(), init, op);
+}
+
+template <typename T, class Allocator, class Stats>
+T parallel_reduce(Deque<T, Allocator, Stats>& deque, T init,
+    const ParallelOptions& options = ParallelOptions()) {
+  return parallel_reduce(deque, init, std::plus<T>(), options);
+}
+
+// Linearizes the deque, sorts one run per thread and merges neighbouring runs
+// pairwise, in parallel, until one is left.
+template <typename T, class Allocator, class Stats, class Compare>
+void parallel_sort(Deque<T, Allocator, Stats>& deque, Compare comp,
+    const ParallelOptions& options = ParallelOptions()) {
+  Span<T> data = deque.linearize();
+  size_t parts = data.size() < options.threshold ? 1 : options.threads;
+  Segments<T> segments;
+  segments.first = data;
+  std::vector<Segments<T>> runs = partition(segments, parts);
+  std::vector<T*> bounds;
+  for (const Segments<T>& run : runs) {
+    bounds.push_back(run.first.begin());
+  }
+  bounds.push_back(data.end());
+
+  run_parallel(runs.size(), [&bounds, &comp](size_t i) {
+    std::sort(bounds[i], bounds[i + 1], comp);
+  });
+  while (bounds.size() > 2) {
+    size_t merges = (bounds.size() - 1) / 2;
+    run_parallel(merges, [&bounds, &comp](size_t i) {
+      std::inplace_merge(bounds[2 * i], bounds[2 * i + 1], bounds[2 * i + 2], comp);
+    });
+    std::vector<T*> merged;
+    for (size_t i = 0; i < bounds.size(); i += 2) {
+      merged.push_back(bounds[i]);
+    }
+    if (merged.back() != bounds.back()) {
+      merged.push_back(bounds.back());
+    }
+    bounds.swap(merged);
+  }
+}
+
+template <typename T, class Allocator, class Stats>
+void parallel_sort(Deque<T, Allocator, Stats>& deque,
+    const ParallelOptions& options = ParallelOptions()) {
+  parallel_sort(deque, std::less<T>(), options);
+}
+}
+#endif
@@ -0,0 +1,272 @@
+#ifndef _FDT_PRIORITY_LANE_QUEUE_H_
+#define _FDT_PRIORITY_LANE_QUEUE_H_
+
+#include "Layout.h"
+#include "LockfreeQueue.h"
+#include "OccupancyBitmap.h"
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <utility>
+
+namespace fdt {
+enum class LanePolicy {
+  Strict,              // always serve the lowest non-empty lane
+  WeightedRoundRobin,  // serve up to weight(lane) elements per lane per round
+  DeficitRoundRobin    // serve up to weight(lane) cost per lane per round
+};
+
+// Cost of an element under LanePolicy::DeficitRoundRobin when none is given:
+// every element costs 1, which makes it behave like weighted round-robin.
+struct UnitCost {
+  template <typename T>
+  size_t operator()(const T&) const {
+    return 1;
+  }
+};
+
+// Single-consumer queue with `Lanes` priority lanes, lane 0 the most urgent.
+// Each lane is a LockfreeQueue with one producer thread of its own, so
+// producers on different lanes never contend. The consumer keeps a bitmap of
+// lanes that may hold elements, with the same set-then-recheck protocol as
+// FanInQueue, and finds the next lane to serve with a single bit scan.
+//
+// Under DeficitRoundRobin a lane earns weight(lane) credit each time its turn
+// comes and spends cost(element) per element taken, so lanes share the
+// consumer in proportion to their weights measured in, say, bytes instead of
+// messages. A lane that runs empty forfeits its unspent credit.
+template <typename T, size_t Lanes, class Cost = UnitCost, class Allocator = std::allocator<T>>
+class PriorityLaneQueue {
+  static_assert(Lanes > 0, "PriorityLaneQueue: needs at least one lane");
+
+public:
+  explicit PriorityLaneQueue(size_t lane_capacity = DEFAULT_CAPACITY,
+      LanePolicy policy = LanePolicy::Strict, const Cost& cost = Cost(),
+      const Allocator& alloca = Allocator());
+  PriorityLaneQueue(const PriorityLaneQueue&) = delete;
+  PriorityLaneQueue& operator=(const PriorityLaneQueue&) = delete;
+
+  // Producer side; each lane may have one producer thread at a time.
+  bool try_push(size_t lane, T value);
+  void push(size_t lane, T value);
+
+  // Consumer side.
+  bool try_pop(T& value);
+  template <class Consumer>
+  size_t drain(Consumer consume, size_t limit);
+  // Weights only matter to the round-robin policies; they default to 1.
+  void set_weight(size_t lane, size_t weight);
+  size_t weight(size_t lane) const;
+
+  size_t size() const;
+  size_t size(size_t lane) const;
+  bool empty() const;
+  LanePolicy policy() const;
+
+private:
+  struct Lane {
+    LockfreeQueue<T, Allocator> queue;
+    size_t weight;
+    size_t credit;
+
+    Lane(size_t capacity, const Allocator& alloca) : queue(capacity, alloca), weight(1), credit(0) {}
+  };
+
+  static const size_t DEFAULT_CAPACITY = 1024;
+  CacheAlignedArray<Lane> lanes_;
+  OccupancyBitmap occupancy_;
+  LanePolicy policy_;
+  Cost cost_;
+  size_t current_;
+
+  Lane& lane(size_t index) const;
+  size_t next_lane(size_t after) const;
+  size_t select();
+  void check_lane(size_t index) const;
+  void drained(size_t index);
+};
+
+template <typename T, size_t Lanes, class Cost, class Allocator>
+PriorityLaneQueue<T, Lanes, Cost, Allocator>::PriorityLaneQueue(size_t lane_capacity,
+    LanePolicy policy, const Cost& cost, const Allocator& alloca)
+    : lanes_(Lanes), occupancy_(Lanes), policy_(policy), cost_(cost), current_(Lanes - 1) {
+  for (size_t i = 0; i < Lanes; i++) {
+    lanes_.emplace_back(lane_capacity, alloca);
+  }
+}
+
+template <typename T, size_t Lanes, class Cost, class Allocator>
+bool PriorityLaneQueue<T, Lanes, Cost, Allocator>::try_push(size_t index, T value) {
+  check_lane(index);
+  LockfreeQueue<T, Allocator>& queue = lane(index).queue;
+  if (queue.full()) {
+    return false;
+  }
+  queue.push_back(std::move(value));
+  if (!occupancy_.test(index)) {
+    occupancy_.set(index);
+  }
+  return true;
+}
+
+// Spins, yielding, while the lane is full.
+template <typename T, size_t Lanes, class Cost, class Allocator>
+void PriorityLaneQueue<T, Lanes, Cost, Allocator>::push(size_t index, T value) {
+  while (!try_push(index, value)) {
+    std::this_thread::yield();
+  }
+}
+
+template <typename T, size_t Lanes, class Cost, class Allocator>
+bool PriorityLaneQueue<T, Lanes, Cost, Allocator>::try_pop(T& value) {
+  size_t index = select();
+  if (index == Lanes) {
+    return false;
+  }
+  LockfreeQueue<T, Allocator>& queue = lane(index).queue;
+  value = std::move(queue.front());
+  queue.pop_front();
+  if (queue.empty()) {
+    drained(index);
+  }
+  return true;
+}
+
+// Hands up to `limit` elements to `consume(T&)`, in the order try_pop would
+// return them, and returns how many were consumed.
+template <typename T, size_t Lanes, class Cost, class Allocator>
+template <class Consumer>
+size_t PriorityLaneQueue<T, Lanes, Cost, Allocator>::drain(Consumer consume, size_t limit) {
+  size_t count = 0;
+  while (count < limit) {
+    size_t index = select();
+    if (index == Lanes) {
+      break;
+    }
+    LockfreeQueue<T, Allocator>& queue = lane(index).queue;
+    consume(queue.front());
+    queue.pop_front();
+    if (queue.empty()) {
+      drained(index);
+    }
+    count++;
+  }
+  return count;
+}
+
+template <typename T, size_t Lanes, class Cost, class Allocator>
+void PriorityLaneQueue<T, Lanes, Cost, Allocator>::set_weight(size_t index, size_t weight) {
+  check_lane(index);
+  if (weight == 0) {
+    throw std::invalid_argument("PriorityLaneQueue: lane weight must be positive");
+  }
+  lane(index).weight = weight;
+}
+
+template <typename T, size_t Lanes, class Cost, class Allocator>
+size_t PriorityLaneQueue<T, Lanes, Cost, Allocator>::weight(size_t index) const {
+  check_lane(index);
+  return lane(index).weight;
+}
+
+template <typename T, size_t Lanes, class Cost, class Allocator>
+size_t PriorityLaneQueue<T, Lanes, Cost, Allocator>::size() const {
+  size_t size = 0;
+  for (size_t i = occupancy_.next(0); i < Lanes; i = occupancy_.next(i + 1)) {
+    size += lane(i).queue.size();
+  }
+  return size;
+}
+
+template <typename T, size_t Lanes, class Cost, class Allocator>
+size_t PriorityLaneQueue<T, Lanes, Cost, Allocator>::size(size_t index) const {
+  check_lane(index);
+  return lane(index).queue.size();
+}
+
+template <typename T, size_t Lanes, class Cost, class Allocator>
+bool PriorityLaneQueue<T, Lanes, Cost, Allocator>::empty() const {
+  return !occupancy_.any();
+}
+
+template <typename T, size_t Lanes, class Cost, class Allocator>
+LanePolicy PriorityLaneQueue<T, Lanes, Cost, Allocator>::policy() const {
+  return policy_;
+}
+
+template <typename T, size_t Lanes, class Cost, class Allocator>
+typename PriorityLaneQueue<T, Lanes, Cost, Allocator>::Lane&
+PriorityLaneQueue<T, Lanes, Cost, Allocator>::lane(size_t index) const {
+  return lanes_[index];
+}
+
+// First occupied lane after `after`, wrapping around, or Lanes if none is.
+template <typename T, size_t Lanes, class Cost, class Allocator>
+size_t PriorityLaneQueue<T, Lanes, Cost, Allocator>::next_lane(size_t after) const {
+  size_t index = occupancy_.next(after + 1);
+  return index < Lanes ? index : occupancy_.next(0);
+}
+
+// Picks the lane the next element comes from and charges it for that
+// element, or returns Lanes when every lane is empty.
+template <typename T, size_t Lanes, class Cost, class Allocator>
+size_t PriorityLaneQueue<T, Lanes, Cost, Allocator>::select() {
+  if (policy_ == LanePolicy::Strict) {
+    for (size_t index = occupancy_.next(0); index < Lanes; index = occupancy_.next(0)) {
+      // A bit can briefly stay set on a lane that was just emptied, when the
+      // producer's set lands after the consumer's re-check.
+      if (!lane(index).queue.empty()) {
+        return index;
+      }
+      drained(index);
+    }
+    return Lanes;
+  }
+  while (true) {
+    Lane& current = lane(current_);
+    if (!current.queue.empty()) {
+      size_t cost = policy_ == LanePolicy::WeightedRoundRobin ? 1 : cost_(current.queue.front());
+      if (cost <= current.credit) {
+        current.credit -= cost;
+        return current_;
+      }
+    } else {
+      if (occupancy_.test(current_)) {
+        drained(current_);
+      }
+      current.credit = 0;
+    }
+    // The current lane's turn is over. Under deficit round-robin it keeps
+    // what it could not spend, unless it ran empty.
+    size_t next = next_lane(current_);
+    if (next == Lanes) {
+      return Lanes;
+    }
+    current_ = next;
+    Lane& granted = lane(next);
+    granted.credit = policy_ == LanePolicy::WeightedRoundRobin
+      ? granted.weight : granted.credit + granted.weight;
+  }
+}
+
+template <typename T, size_t Lanes, class Cost, class Allocator>
+void PriorityLaneQueue<T, Lanes, Cost, Allocator>::check_lane(size_t index) const {
+  if (index >= Lanes) {
+    throw std::out_of_range("PriorityLaneQueue: lane " + std::to_string(index)
+        + " is out of range for " + std::to_string(Lanes) + " lanes");
+  }
+}
+
+template <typename T, size_t Lanes, class Cost, class Allocator>
+void PriorityLaneQueue<T, Lanes, Cost, Allocator>::drained(size_t index) {
+  occupancy_.clear(index);
+  if (!lane(index).queue.empty()) {
+    occupancy_.set(index);
+  }
+}
+}
+#endif
@@ -0,0 +1,289 @@
+#ifndef _FDT_REPLAY_RING_H_
+#define _FDT_REPLAY_RING_H_
+
+#include "Layout.h"
+#include "Span.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <sstream>
+#include <stdexcept>
+#include <type_traits>
+
+namespace fdt {
+enum class ReplayStatus {
+  Found,    // the element is still buffered
+  Evicted,  // the element was overwritten or released
+  Ahead     // no element with this sequence has been pushed yet
+};
+
+// Fixed-size ring that numbers every element it takes with a 64-bit sequence,
+// counting up from first_sequence, and keeps the newest capacity of them.
+// Unlike a Deque index, a sequence keeps naming the same element for as long
+// as it is buffered, so a retransmission request for message N is one masked
+// lookup. When the ring is full a push overwrites the oldest element;
+// release() drops acknowledged elements early.
+template <typename T, class Allocator = std::allocator<T>>
+class ReplayRing {
+public:
+  explicit ReplayRing(size_t capacity, uint64_t first_sequence = 0,
+      const Allocator& alloca = Allocator());
+  ReplayRing(const ReplayRing&) = delete;
+  ReplayRing& operator=(const ReplayRing&) = delete;
+  ~ReplayRing();
+
+  // Returns the sequence given to value.
+  uint64_t push(T value);
+  // Drops every element before sequence.
+  void release(uint64_t sequence);
+
+  ReplayStatus get(uint64_t sequence, T& value) const;
+  // The elements [first, last) as at most two contiguous spans. Throws
+  // out_of_range unless oldest() <= first <= last <= next().
+  Segments<const T> range(uint64_t first, uint64_t last) const;
+
+  // Sequences of the oldest buffered element and of the next push.
+  uint64_t oldest() const;
+  uint64_t next() const;
+  size_t size() const;
+  size_t capacity() const;
+  bool empty() const;
+
+private:
+  T* container_;
+  Allocator alloca_;
+  size_t mask_;
+  uint64_t oldest_;
+  uint64_t next_;
+};
+
+// ReplayRing for one writer thread and any number of reader threads, without
+// locks. Every slot carries the sequence of the element in it, which the
+// writer sets to an odd value while it overwrites the slot and to an even
+// one once done, so a reader validates a copy against the slot alone and
+// never contends with readers of other slots. The writer never waits; a
+// reader that loses a slot to the writer reports the element as evicted.
+// Stamps are twice the sequence plus one or two and overflow from sequence
+// 2^63 - 1 on, so first_sequence has to be below 2^62, which leaves more
+// pushes than a ring will ever take.
+//
+// As with SeqlockDeque, T has to be trivially copyable, since readers may
+// copy a slot the writer is overwriting and then discard the torn copy.
+template <typename T>
+class ConcurrentReplayRing {
+  static_assert(std::is_trivially_copyable<T>::value,
+      "ConcurrentReplayRing: T must be trivially copyable");
+
+public:
+  explicit ConcurrentReplayRing(size_t capacity, uint64_t first_sequence = 0);
+  ConcurrentReplayRing(const ConcurrentReplayRing&) = delete;
+  ConcurrentReplayRing& operator=(const ConcurrentReplayRing&) = delete;
+  ~ConcurrentReplayRing();
+
+  // Writer side.
+  uint64_t push(const T& value);
+
+  // Reader side, safe from any thread. get() leaves value unspecified unless
+  // it returns Found. read() copies the elements from first on, up to count
+  // of them, and stops at the first one it cannot return.
+  ReplayStatus get(uint64_t sequence, T& value) const;
+  size_t read(uint64_t first, size_t count, T* out) const;
+  uint64_t next() const;
+  size_t capacity() const;
+
+private:
+  struct Slot {
+    std::atomic<uint64_t> stamp;
+    T value;
+
+    Slot() : stamp(0) {}
+  };
+
+  static const uint64_t MAX_FIRST_SEQUENCE = uint64_t(1) << 62;
+
+  Slot* slots_;
+  size_t mask_;
+  uint64_t first_;
+  std::atomic<uint64_t> next_;
+
+  // Stamps of a slot while the element with this sequence is being written
+  // and once it is in place. Zero marks a slot never written.
+  static uint64_t writing(uint64_t sequence);
+  static uint64_t written(uint64_t sequence);
+};
+
+// The capacity is rounded up to a power of two so that sequences map to
+// slots with a mask.
+template <typename T, class Allocator>
+ReplayRing<T, Allocator>::ReplayRing(size_t capacity, uint64_t first_sequence,
+    const Allocator& alloca)
+    : alloca_(alloca), oldest_(first_sequence), next_(first_sequence) {
+  size_t rounded = round_up_pow2(capacity);
+  mask_ = rounded - 1;
+  container_ = alloca_.allocate(rounded);
+  if (!std::is_trivial<T>::value) {
+    std::uninitialized_fill_n(container_, rounded, T());
+  }
+}
+
+template <typename T, class Allocator>
+ReplayRing<T, Allocator>::~ReplayRing() {
+  if (!std::is_trivial<T>::value) {
+    for (size_t i = 0; i <= mask_; i++) {
+      container_[i].~T();
+    }
+  }
+  alloca_.deallocate(container_, mask_ + 1);
+}
+
+template <typename T, class Allocator>
+uint64_t ReplayRing<T, Allocator>::push(T value) {
+  if (next_ - oldest_ == capacity()) {
+    oldest_++;
+  }
+  container_[next_ & mask_] = std::move(value);
+  return next_++;
+}
+
+template <typename T, class Allocator>
+void ReplayRing<T, Allocator>::release(uint64_t sequence) {
+  oldest_ = std::max(oldest_, std::min(sequence, next_));
+}
+
+template <typename T, class Allocator>
+ReplayStatus ReplayRing<T, Allocator>::get(uint64_t sequence, T& value) const {
+  if (sequence >= next_) {
+    return ReplayStatus::Ahead;
+  }
+  if (sequence < oldest_) {
+    return ReplayStatus::Evicted;
+  }
+  value = container_[sequence & mask_];
+  return ReplayStatus::Found;
+}
+
+template <typename T, class Allocator>
+Segments<const T> ReplayRing<T, Allocator>::range(uint64_t first, uint64_t last) const {
+  if (first < oldest_ || first > last || last > next_) {
+    std::ostringstream out;
+    out << "ReplayRing: range [" << first << ", " << last << ") is not within the buffered ["
+      << oldest_ << ", " << next_ << ")";
+    throw std::out_of_range(out.str());
+  }
+  size_t start = first & mask_;
+  size_t count = last - first;
+  size_t head = std::min(count, capacity() - start);
+  Segments<const T> segments;
+  segments.first = Span<const T>(container_ + start, head);
+  segments.second = Span<const T>(container_, count - head);
+  return segments;
+}
+
+template <typename T, class Allocator>
+uint64_t ReplayRing<T, Allocator>::oldest() const {
+  return oldest_;
+}
+
+template <typename T, class Allocator>
+uint64_t ReplayRing<T, Allocator>::next() const {
+  return next_;
+}
+
+template <typename T, class Allocator>
+size_t ReplayRing<T, Allocator>::size() const {
+  return next_ - oldest_;
+}
+
+template <typename T, class Allocator>
+size_t ReplayRing<T, Allocator>::capacity() const {
+  return mask_ + 1;
+}
+
+template <typename T, class Allocator>
+bool ReplayRing<T, Allocator>::empty() const {
+  return next_ == oldest_;
+}
+
+template <typename T>
+ConcurrentReplayRing<T>::ConcurrentReplayRing(size_t capacity, uint64_t first_sequence)
+    : first_(first_sequence), next_(first_sequence) {
+  if (first_sequence >= MAX_FIRST_SEQUENCE) {
+    throw std::invalid_argument("ConcurrentReplayRing: first_sequence must be below 2^62");
+  }
+  size_t rounded = round_up_pow2(capacity);
+  mask_ = rounded - 1;
+  slots_ = new Slot[rounded];
+}
+
+template <typename T>
+ConcurrentReplayRing<T>::~ConcurrentReplayRing() {
+  delete[] slots_;
+}
+
+template <typename T>
+uint64_t ConcurrentReplayRing<T>::push(const T& value) {
+  uint64_t sequence = next_.load(std::memory_order_relaxed);
+  Slot& slot = slots_[sequence & mask_];
+  slot.stamp.store(writing(sequence), std::memory_order_relaxed);
+  std::atomic_thread_fence(std::memory_order_release);
+  std::memcpy(&slot.value, &value, sizeof(T));
+  slot.stamp.store(written(sequence), std::memory_order_release);
+  next_.store(sequence + 1, std::memory_order_release);
+  return sequence;
+}
+
+template <typename T>
+ReplayStatus ConcurrentReplayRing<T>::get(uint64_t sequence, T& value) const {
+  if (sequence >= next_.load(std::memory_order_acquire)) {
+    return ReplayStatus::Ahead;
+  }
+  if (sequence < first_) {
+    return ReplayStatus::Evicted;
+  }
+  // The element was published, so any stamp but its own means the writer
+  // has moved on to a later sequence in this slot.
+  const Slot& slot = slots_[sequence & mask_];
+  if (slot.stamp.load(std::memory_order_acquire) != written(sequence)) {
+    return ReplayStatus::Evicted;
+  }
+  std::memcpy(&value, &slot.value, sizeof(T));
+  std::atomic_thread_fence(std::memory_order_acquire);
+  if (slot.stamp.load(std::memory_order_relaxed) != written(sequence)) {
+    return ReplayStatus::Evicted;
+  }
+  return ReplayStatus::Found;
+}
+
+template <typename T>
+size_t ConcurrentReplayRing<T>::read(uint64_t first, size_t count, T* out) const {
+  size_t copied = 0;
+  while (copied < count && get(first + copied, out[copied]) == ReplayStatus::Found) {
+    copied++;
+  }
+  return copied;
+}
+
+template <typename T>
+uint64_t ConcurrentReplayRing<T>::next() const {
+  return next_.load(std::memory_order_acquire);
+}
+
+template <typename T>
+size_t ConcurrentReplayRing<T>::capacity() const {
+  return mask_ + 1;
+}
+
+template <typename T>
+inline uint64_t ConcurrentReplayRing<T>::writing(uint64_t sequence) {
+  return 2 * sequence + 1;
+}
+
+template <typename T>
+inline uint64_t ConcurrentReplayRing<T>::written(uint64_t sequence) {
+  return 2 * sequence + 2;
+}
+}
+#endif
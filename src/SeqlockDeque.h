@@ -0,0 +1,276 @@
+#ifndef _FDT_SEQLOCK_DEQUE_H_
+#define _FDT_SEQLOCK_DEQUE_H_
+
+#include "Layout.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <stdexcept>
+#include <type_traits>
+#include <vector>
+
+namespace fdt {
+// Deque with one writer thread and any number of reader threads. The writer
+// never waits for readers: it publishes every change to the layout under a
+// sequence counter that is odd while a change is in progress, and readers
+// copy what they need optimistically and retry when the counter moved
+// underneath them.
+//
+// Elements are always written to free slots, which no consistent view of the
+// deque covers. push_back then only has to publish the larger size, which it
+// does without touching the counter, so readers never retry because of
+// appends; a slot behind the back is not reused before a pop or a growth,
+// both of which bump the counter. The other changes move the front or
+// shrink the deque and take one short section each.
+//
+// When the buffer grows, the old one is retired rather than freed, since a
+// reader may still be copying from it. Readers register for the duration of
+// a read, and retired buffers are freed by the writer once it sees no reader
+// registered.
+//
+// Readers copy elements while the writer may be overwriting them, which the
+// sequence check then discards; T has to be trivially copyable for such a
+// torn copy to be harmless.
+template <typename T, class Allocator = std::allocator<T>>
+class SeqlockDeque {
+  static_assert(std::is_trivially_copyable<T>::value,
+      "SeqlockDeque: T must be trivially copyable");
+
+public:
+  SeqlockDeque();
+  explicit SeqlockDeque(size_t capacity, const Allocator& alloca = Allocator());
+  SeqlockDeque(const SeqlockDeque&) = delete;
+  SeqlockDeque& operator=(const SeqlockDeque&) = delete;
+  ~SeqlockDeque();
+
+  // Writer side.
+  void push_back(const T& value);
+  void push_front(const T& value);
+  void pop_front();
+  void pop_back();
+  void clear();
+  // Frees retired buffers if no reader is registered.
+  void reclaim();
+
+  // Reader side, safe from any thread. read(index, value) returns false when
+  // index is out of range; read(index, count, out) copies up to count
+  // elements starting at index and returns how many it copied. Either way the
+  // result is a state of the deque that existed at some point during the call.
+  bool read(size_t index, T& value) const;
+  size_t read(size_t index, size_t count, T* out) const;
+  size_t size() const;
+  bool empty() const;
+
+private:
+  struct Buffer {
+    T* data;
+    size_t capacity;
+  };
+
+  // Registers a reader from construction to destruction.
+  class ReadGuard {
+  public:
+    explicit ReadGuard(const SeqlockDeque& deque) : readers_(deque.readers_) {
+      readers_.fetch_add(1);
+    }
+    ~ReadGuard() {
+      readers_.fetch_sub(1, std::memory_order_release);
+    }
+
+  private:
+    std::atomic<size_t>& readers_;
+  };
+
+  Allocator alloca_;
+  std::atomic<Buffer*> buffer_;
+  std::atomic<size_t> front_;
+  std::atomic<size_t> size_;
+  std::vector<Buffer*> retired_;
+  alignas(64) std::atomic<uint64_t> sequence_;
+  alignas(64) mutable std::atomic<size_t> readers_;
+
+  static const size_t DEFAULT_CAPACITY = 64;
+
+  void begin_write();
+  void end_write();
+  void grow();
+  void release(Buffer* buffer);
+  void check_nonempty() const;
+};
+
+template <typename T, class Allocator>
+SeqlockDeque<T, Allocator>::SeqlockDeque() : SeqlockDeque(DEFAULT_CAPACITY) {}
+
+// The capacity is rounded up to a power of two so that readers can wrap
+// indices with a mask.
+template <typename T, class Allocator>
+SeqlockDeque<T, Allocator>::SeqlockDeque(size_t capacity, const Allocator& alloca)
+    : alloca_(alloca), front_(0), size_(0), sequence_(0), readers_(0) {
+  size_t rounded = round_up_pow2(capacity);
+  buffer_.store(new Buffer{alloca_.allocate(rounded), rounded});
+}
+
+template <typename T, class Allocator>
+SeqlockDeque<T, Allocator>::~SeqlockDeque() {
+  for (Buffer* buffer : retired_) {
+    release(buffer);
+  }
+  release(buffer_.load());
+}
+
+template <typename T, class Allocator>
+void SeqlockDeque<T, Allocator>::push_back(const T& value) {
+  Buffer* buffer = buffer_.load(std::memory_order_relaxed);
+  size_t size = size_.load(std::memory_order_relaxed);
+  if (size == buffer->capacity) {
+    grow();
+    buffer = buffer_.load(std::memory_order_relaxed);
+  }
+  size_t front = front_.load(std::memory_order_relaxed);
+  std::memcpy(buffer->data + ((front + size) & (buffer->capacity - 1)), &value, sizeof(T));
+  size_.store(size + 1, std::memory_order_release);
+}
+
+template <typename T, class Allocator>
+void SeqlockDeque<T, Allocator>::push_front(const T& value) {
+  Buffer* buffer = buffer_.load(std::memory_order_relaxed);
+  size_t size = size_.load(std::memory_order_relaxed);
+  if (size == buffer->capacity) {
+    grow();
+    buffer = buffer_.load(std::memory_order_relaxed);
+  }
+  size_t front = (front_.load(std::memory_order_relaxed) - 1) & (buffer->capacity - 1);
+  std::memcpy(buffer->data + front, &value, sizeof(T));
+  begin_write();
+  front_.store(front, std::memory_order_relaxed);
+  size_.store(size + 1, std::memory_order_relaxed);
+  end_write();
+}
+
+template <typename T, class Allocator>
+void SeqlockDeque<T, Allocator>::pop_front() {
+  check_nonempty();
+  Buffer* buffer = buffer_.load(std::memory_order_relaxed);
+  begin_write();
+  front_.store((front_.load(std::memory_order_relaxed) + 1) & (buffer->capacity - 1),
+      std::memory_order_relaxed);
+  size_.store(size_.load(std::memory_order_relaxed) - 1, std::memory_order_relaxed);
+  end_write();
+}
+
+template <typename T, class Allocator>
+void SeqlockDeque<T, Allocator>::pop_back() {
+  check_nonempty();
+  begin_write();
+  size_.store(size_.load(std::memory_order_relaxed) - 1, std::memory_order_relaxed);
+  end_write();
+}
+
+template <typename T, class Allocator>
+void SeqlockDeque<T, Allocator>::clear() {
+  begin_write();
+  front_.store(0, std::memory_order_relaxed);
+  size_.store(0, std::memory_order_relaxed);
+  end_write();
+}
+
+template <typename T, class Allocator>
+void SeqlockDeque<T, Allocator>::reclaim() {
+  // A reader registers before it loads the buffer, so once no reader is
+  // registered after a buffer was replaced, none can still be using it.
+  if (retired_.empty() || readers_.load() != 0) {
+    return;
+  }
+  for (Buffer* buffer : retired_) {
+    release(buffer);
+  }
+  retired_.clear();
+}
+
+template <typename T, class Allocator>
+bool SeqlockDeque<T, Allocator>::read(size_t index, T& value) const {
+  return read(index, 1, &value) == 1;
+}
+
+template <typename T, class Allocator>
+size_t SeqlockDeque<T, Allocator>::read(size_t index, size_t count, T* out) const {
+  ReadGuard guard(*this);
+  while (true) {
+    uint64_t before = sequence_.load(std::memory_order_acquire);
+    if (before & 1) {
+      continue;
+    }
+    const Buffer* buffer = buffer_.load();
+    size_t front = front_.load(std::memory_order_relaxed);
+    size_t size = size_.load(std::memory_order_acquire);
+    // A size published after a growth this read has not seen yet may exceed
+    // the old buffer; the copy is discarded below, but must stay in bounds.
+    size_t copied = index < size ? std::min(std::min(count, size - index), buffer->capacity) : 0;
+    size_t start = (front + index) & (buffer->capacity - 1);
+    size_t first = std::min(copied, buffer->capacity - start);
+    std::memcpy(out, buffer->data + start, first * sizeof(T));
+    std::memcpy(out + first, buffer->data, (copied - first) * sizeof(T));
+    std::atomic_thread_fence(std::memory_order_acquire);
+    if (sequence_.load(std::memory_order_relaxed) == before) {
+      return copied;
+    }
+  }
+}
+
+template <typename T, class Allocator>
+size_t SeqlockDeque<T, Allocator>::size() const {
+  return size_.load(std::memory_order_relaxed);
+}
+
+template <typename T, class Allocator>
+bool SeqlockDeque<T, Allocator>::empty() const {
+  return size() == 0;
+}
+
+template <typename T, class Allocator>
+void SeqlockDeque<T, Allocator>::begin_write() {
+  sequence_.store(sequence_.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+  std::atomic_thread_fence(std::memory_order_release);
+}
+
+template <typename T, class Allocator>
+void SeqlockDeque<T, Allocator>::end_write() {
+  sequence_.store(sequence_.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+}
+
+// Copies into a buffer twice the size while readers keep using the old one,
+// then switches them over in one section.
+template <typename T, class Allocator>
+void SeqlockDeque<T, Allocator>::grow() {
+  Buffer* old = buffer_.load(std::memory_order_relaxed);
+  size_t front = front_.load(std::memory_order_relaxed);
+  size_t size = size_.load(std::memory_order_relaxed);
+  Buffer* buffer = new Buffer{alloca_.allocate(old->capacity * 2), old->capacity * 2};
+  size_t first = std::min(size, old->capacity - front);
+  std::memcpy(buffer->data, old->data + front, first * sizeof(T));
+  std::memcpy(buffer->data + first, old->data, (size - first) * sizeof(T));
+  begin_write();
+  buffer_.store(buffer);
+  front_.store(0, std::memory_order_relaxed);
+  end_write();
+  retired_.push_back(old);
+  reclaim();
+}
+
+template <typename T, class Allocator>
+void SeqlockDeque<T, Allocator>::release(Buffer* buffer) {
+  alloca_.deallocate(buffer->data, buffer->capacity);
+  delete buffer;
+}
+
+template <typename T, class Allocator>
+void SeqlockDeque<T, Allocator>::check_nonempty() const {
+  if (size_.load(std::memory_order_relaxed) == 0) {
+    throw std::out_of_range("SeqlockDeque: cannot pop from empty deque");
+  }
+}
+}
+#endif
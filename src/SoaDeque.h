@@ -0,0 +1,438 @@
+#ifndef _FDT_SOA_DEQUE_H_
+#define _FDT_SOA_DEQUE_H_
+
+#include "Span.h"
+
+#include <algorithm>
+#include <cstring>
+#include <memory>
+#include <new>
+#include <sstream>
+#include <stdexcept>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+namespace fdt {
+template <size_t... Indices>
+struct IndexSequence {};
+
+template <size_t N, size_t... Indices>
+struct MakeIndexSequence : MakeIndexSequence<N - 1, N - 1, Indices...> {};
+
+template <size_t... Indices>
+struct MakeIndexSequence<0, Indices...> {
+  typedef IndexSequence<Indices...> type;
+};
+
+// Deque of records stored as a struct of arrays: one circular column per
+// field, all sharing the same front and size. Whole records are pushed and
+// popped at both ends like in Deque, while column<I>() exposes one field of
+// every record as at most two contiguous spans, so a scan over a single field
+// reads only that field's bytes and vectorizes like a loop over an array.
+//
+//   SoaDeque<uint64_t, double, uint32_t> ticks;   // timestamp, price, qty
+//   ticks.push_back(now, 101.5, 300);
+//   Segments<double> prices = ticks.column<1>();
+template <typename... Fields>
+class SoaDeque {
+public:
+  typedef std::tuple<Fields...> value_type;
+  typedef std::tuple<Fields&...> reference;
+  typedef std::tuple<const Fields&...> const_reference;
+  template <size_t I>
+  using field_type = typename std::tuple_element<I, value_type>::type;
+
+  SoaDeque();
+  explicit SoaDeque(size_t capacity);
+  SoaDeque(const SoaDeque& deque);
+  ~SoaDeque();
+  SoaDeque& operator=(const SoaDeque& deque);
+
+  void push_front(const Fields&... values);
+  void push_back(const Fields&... values);
+  void pop_front();
+  void pop_back();
+  void reserve(size_t capacity);
+  void clear();
+  void swap(SoaDeque& deque);
+
+  reference front();
+  reference back();
+  reference at(size_t index);
+  reference operator[](size_t index);
+  const_reference front() const;
+  const_reference back() const;
+  const_reference at(size_t index) const;
+  const_reference operator[](size_t index) const;
+
+  template <size_t I>
+  field_type<I>& get(size_t index);
+  template <size_t I>
+  const field_type<I>& get(size_t index) const;
+  template <size_t I>
+  Segments<field_type<I>> column();
+  template <size_t I>
+  Segments<const field_type<I>> column() const;
+
+  size_t capacity() const;
+  size_t size() const;
+  bool empty() const;
+
+private:
+  typedef typename MakeIndexSequence<sizeof...(Fields)>::type Indices;
+
+  std::tuple<Fields*...> columns_;
+  size_t capacity_;
+  size_t size_;
+  size_t front_;
+
+  static const size_t DEFAULT_CAPACITY = 64;
+
+  size_t position(size_t index) const;
+  void grow();
+  template <size_t... I>
+  void construct(IndexSequence<I...>, size_t position, const Fields&... values);
+  template <size_t... I>
+  void destroy(IndexSequence<I...>, size_t position);
+  template <size_t... I>
+  void relocate(IndexSequence<I...>, std::tuple<Fields*...>& columns);
+  template <size_t... I>
+  void copy(IndexSequence<I...>, const SoaDeque& deque);
+  template <size_t... I>
+  void allocate(IndexSequence<I...>, std::tuple<Fields*...>& columns, size_t capacity);
+  template <size_t... I>
+  void deallocate(IndexSequence<I...>, std::tuple<Fields*...>& columns, size_t capacity);
+  template <size_t... I>
+  reference record(IndexSequence<I...>, size_t position);
+  template <size_t... I>
+  const_reference record(IndexSequence<I...>, size_t position) const;
+
+  template <typename F>
+  static void relocate_range(F* from, size_t count, F* to, std::true_type);
+  template <typename F>
+  static void relocate_range(F* from, size_t count, F* to, std::false_type);
+  template <typename F>
+  static void destroy_at(F* value);
+
+  void out_of_range(size_t index) const;
+  void check_nonempty() const;
+};
+
+template <typename... Fields>
+SoaDeque<Fields...>::SoaDeque() : SoaDeque(DEFAULT_CAPACITY) {}
+
+template <typename... Fields>
+SoaDeque<Fields...>::SoaDeque(size_t capacity)
+    : capacity_(std::max(capacity, (size_t) 1)), size_(0), front_(0) {
+  allocate(Indices(), columns_, capacity_);
+}
+
+template <typename... Fields>
+SoaDeque<Fields...>::SoaDeque(const SoaDeque& deque) : SoaDeque(deque.capacity_) {
+  copy(Indices(), deque);
+  size_ = deque.size_;
+}
+
+template <typename... Fields>
+SoaDeque<Fields...>::~SoaDeque() {
+  clear();
+  deallocate(Indices(), columns_, capacity_);
+}
+
+template <typename... Fields>
+SoaDeque<Fields...>& SoaDeque<Fields...>::operator=(const SoaDeque& deque) {
+  if (this != &deque) {
+    SoaDeque copy(deque);
+    swap(copy);
+  }
+  return *this;
+}
+
+template <typename... Fields>
+void SoaDeque<Fields...>::push_front(const Fields&... values) {
+  if (size_ == capacity_) {
+    grow();
+  }
+  size_t front = front_ == 0 ? capacity_ - 1 : front_ - 1;
+  construct(Indices(), front, values...);
+  front_ = front;
+  size_++;
+}
+
+template <typename... Fields>
+void SoaDeque<Fields...>::push_back(const Fields&... values) {
+  if (size_ == capacity_) {
+    grow();
+  }
+  construct(Indices(), position(size_), values...);
+  size_++;
+}
+
+template <typename... Fields>
+void SoaDeque<Fields...>::pop_front() {
+  check_nonempty();
+  destroy(Indices(), front_);
+  front_ = position(1);
+  size_--;
+}
+
+template <typename... Fields>
+void SoaDeque<Fields...>::pop_back() {
+  check_nonempty();
+  destroy(Indices(), position(size_ - 1));
+  size_--;
+}
+
+template <typename... Fields>
+void SoaDeque<Fields...>::reserve(size_t capacity) {
+  if (capacity <= capacity_) {
+    return;
+  }
+  std::tuple<Fields*...> columns;
+  allocate(Indices(), columns, capacity);
+  relocate(Indices(), columns);
+  deallocate(Indices(), columns_, capacity_);
+  columns_ = columns;
+  capacity_ = capacity;
+  front_ = 0;
+}
+
+template <typename... Fields>
+void SoaDeque<Fields...>::clear() {
+  for (size_t i = 0; i < size_; i++) {
+    destroy(Indices(), position(i));
+  }
+  size_ = 0;
+  front_ = 0;
+}
+
+template <typename... Fields>
+void SoaDeque<Fields...>::swap(SoaDeque& deque) {
+  std::swap(columns_, deque.columns_);
+  std::swap(capacity_, deque.capacity_);
+  std::swap(size_, deque.size_);
+  std::swap(front_, deque.front_);
+}
+
+template <typename... Fields>
+typename SoaDeque<Fields...>::reference SoaDeque<Fields...>::front() {
+  check_nonempty();
+  return record(Indices(), front_);
+}
+
+template <typename... Fields>
+typename SoaDeque<Fields...>::reference SoaDeque<Fields...>::back() {
+  check_nonempty();
+  return record(Indices(), position(size_ - 1));
+}
+
+template <typename... Fields>
+typename SoaDeque<Fields...>::reference SoaDeque<Fields...>::at(size_t index) {
+  if (index >= size_) {
+    out_of_range(index);
+  }
+  return record(Indices(), position(index));
+}
+
+template <typename... Fields>
+typename SoaDeque<Fields...>::reference SoaDeque<Fields...>::operator[](size_t index) {
+  return record(Indices(), position(index));
+}
+
+template <typename... Fields>
+typename SoaDeque<Fields...>::const_reference SoaDeque<Fields...>::front() const {
+  check_nonempty();
+  return record(Indices(), front_);
+}
+
+template <typename... Fields>
+typename SoaDeque<Fields...>::const_reference SoaDeque<Fields...>::back() const {
+  check_nonempty();
+  return record(Indices(), position(size_ - 1));
+}
+
+template <typename... Fields>
+typename SoaDeque<Fields...>::const_reference SoaDeque<Fields...>::at(size_t index) const {
+  if (index >= size_) {
+    out_of_range(index);
+  }
+  return record(Indices(), position(index));
+}
+
+template <typename... Fields>
+typename SoaDeque<Fields...>::const_reference SoaDeque<Fields...>::operator[](
+    size_t index) const {
+  return record(Indices(), position(index));
+}
+
+template <typename... Fields>
+template <size_t I>
+typename SoaDeque<Fields...>::template field_type<I>& SoaDeque<Fields...>::get(size_t index) {
+  return std::get<I>(columns_)[position(index)];
+}
+
+template <typename... Fields>
+template <size_t I>
+const typename SoaDeque<Fields...>::template field_type<I>& SoaDeque<Fields...>::get(
+    size_t index) const {
+  return std::get<I>(columns_)[position(index)];
+}
+
+template <typename... Fields>
+template <size_t I>
+Segments<typename SoaDeque<Fields...>::template field_type<I>> SoaDeque<Fields...>::column() {
+  field_type<I>* data = std::get<I>(columns_);
+  size_t first = std::min(size_, capacity_ - front_);
+  Segments<field_type<I>> segments;
+  segments.first = Span<field_type<I>>(data + front_, first);
+  segments.second = Span<field_type<I>>(data, size_ - first);
+  return segments;
+}
+
+template <typename... Fields>
+template <size_t I>
+Segments<const typename SoaDeque<Fields...>::template field_type<I>>
+SoaDeque<Fields...>::column() const {
+  const field_type<I>* data = std::get<I>(columns_);
+  size_t first = std::min(size_, capacity_ - front_);
+  Segments<const field_type<I>> segments;
+  segments.first = Span<const field_type<I>>(data + front_, first);
+  segments.second = Span<const field_type<I>>(data, size_ - first);
+  return segments;
+}
+
+template <typename... Fields>
+size_t SoaDeque<Fields...>::capacity() const {
+  return capacity_;
+}
+
+template <typename... Fields>
+size_t SoaDeque<Fields...>::size() const {
+  return size_;
+}
+
+template <typename... Fields>
+bool SoaDeque<Fields...>::empty() const {
+  return size_ == 0;
+}
+
+template <typename... Fields>
+inline size_t SoaDeque<Fields...>::position(size_t index) const {
+  size_t position = front_ + index;
+  return position >= capacity_ ? position - capacity_ : position;
+}
+
+template <typename... Fields>
+void SoaDeque<Fields...>::grow() {
+  reserve(capacity_ * 2);
+}
+
+// The packs below expand once per column; the array only gives the
+// expansion somewhere to happen in C++11.
+template <typename... Fields>
+template <size_t... I>
+void SoaDeque<Fields...>::construct(IndexSequence<I...>, size_t position,
+    const Fields&... values) {
+  int expand[] = {0, (new (std::get<I>(columns_) + position) Fields(values), 0)...};
+  (void) expand;
+}
+
+template <typename... Fields>
+template <size_t... I>
+void SoaDeque<Fields...>::destroy(IndexSequence<I...>, size_t position) {
+  int expand[] = {0, (destroy_at(std::get<I>(columns_) + position), 0)...};
+  (void) expand;
+}
+
+template <typename... Fields>
+template <size_t... I>
+void SoaDeque<Fields...>::relocate(IndexSequence<I...>, std::tuple<Fields*...>& columns) {
+  size_t first = std::min(size_, capacity_ - front_);
+  int expand[] = {0, (relocate_range(std::get<I>(columns_) + front_, first,
+      std::get<I>(columns), std::is_trivially_copyable<Fields>()), 0)...};
+  int wrapped[] = {0, (relocate_range(std::get<I>(columns_), size_ - first,
+      std::get<I>(columns) + first, std::is_trivially_copyable<Fields>()), 0)...};
+  (void) expand;
+  (void) wrapped;
+}
+
+template <typename... Fields>
+template <size_t... I>
+void SoaDeque<Fields...>::copy(IndexSequence<I...>, const SoaDeque& deque) {
+  for (size_t i = 0; i < deque.size_; i++) {
+    size_t from = deque.position(i);
+    int expand[] = {0, (new (std::get<I>(columns_) + i) Fields(std::get<I>(deque.columns_)[from]), 0)...};
+    (void) expand;
+  }
+}
+
+template <typename... Fields>
+template <size_t... I>
+void SoaDeque<Fields...>::allocate(IndexSequence<I...>, std::tuple<Fields*...>& columns,
+    size_t capacity) {
+  int expand[] = {0, (std::get<I>(columns) = std::allocator<Fields>().allocate(capacity), 0)...};
+  (void) expand;
+}
+
+template <typename... Fields>
+template <size_t... I>
+void SoaDeque<Fields...>::deallocate(IndexSequence<I...>, std::tuple<Fields*...>& columns,
+    size_t capacity) {
+  int expand[] = {0, (std::allocator<Fields>().deallocate(std::get<I>(columns), capacity), 0)...};
+  (void) expand;
+}
+
+template <typename... Fields>
+template <size_t... I>
+typename SoaDeque<Fields...>::reference SoaDeque<Fields...>::record(IndexSequence<I...>,
+    size_t position) {
+  return reference(std::get<I>(columns_)[position]...);
+}
+
+template <typename... Fields>
+template <size_t... I>
+typename SoaDeque<Fields...>::const_reference SoaDeque<Fields...>::record(
+    IndexSequence<I...>, size_t position) const {
+  return const_reference(std::get<I>(columns_)[position]...);
+}
+
+template <typename... Fields>
+template <typename F>
+void SoaDeque<Fields...>::relocate_range(F* from, size_t count, F* to, std::true_type) {
+  if (count > 0) {
+    std::memcpy(static_cast<void*>(to), static_cast<const void*>(from), count * sizeof(F));
+  }
+}
+
+template <typename... Fields>
+template <typename F>
+void SoaDeque<Fields...>::relocate_range(F* from, size_t count, F* to, std::false_type) {
+  for (size_t i = 0; i < count; i++) {
+    new (to + i) F(std::move(from[i]));
+    from[i].~F();
+  }
+}
+
+template <typename... Fields>
+template <typename F>
+void SoaDeque<Fields...>::destroy_at(F* value) {
+  value->~F();
+}
+
+template <typename... Fields>
+void SoaDeque<Fields...>::out_of_range(size_t index) const {
+  std::ostringstream out;
+  out << "SoaDeque: index (which is " << index << ") >= this->size() (which is "
+    << size_ << ")";
+  throw std::out_of_range(out.str());
+}
+
+template <typename... Fields>
+void SoaDeque<Fields...>::check_nonempty() const {
+  if (size_ == 0) {
+    throw std::out_of_range("SoaDeque: cannot access element in empty deque");
+  }
+}
+}
+#endif
@@ -0,0 +1,37 @@
+#ifndef _FDT_SPAN_H_
+#define _FDT_SPAN_H_
+
+#include <cstddef>
+
+namespace fdt {
+// Non-owning view of `size` contiguous elements.
+template <typename T>
+class Span {
+public:
+  Span() : data_(nullptr), size_(0) {}
+  Span(T* data, size_t size) : data_(data), size_(size) {}
+
+  T* data() const { return data_; }
+  size_t size() const { return size_; }
+  bool empty() const { return size_ == 0; }
+  T* begin() const { return data_; }
+  T* end() const { return data_ + size_; }
+  T& operator[](size_t index) const { return data_[index]; }
+
+private:
+  T* data_;
+  size_t size_;
+};
+
+// The contents of a circular buffer as at most two contiguous pieces: `first`
+// runs from the front to the end of the buffer (or to the back element), and
+// `second` holds whatever wrapped around to the start.
+template <typename T>
+struct Segments {
+  Span<T> first;
+  Span<T> second;
+
+  size_t size() const { return first.size() + second.size(); }
+};
+}
+#endif
@@ -0,0 +1,155 @@
+#ifndef _FDT_STATS_H_
+#define _FDT_STATS_H_
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+namespace fdt {
+struct StatsSnapshot {
+  uint64_t reallocations = 0;
+  uint64_t reserves = 0;
+  uint64_t bytes_reserved = 0;
+  uint64_t bytes_shifted = 0;
+  uint64_t high_water = 0;
+  uint64_t full_observed = 0;
+  uint64_t empty_observed = 0;
+  uint64_t producer_waits = 0;
+  uint64_t consumer_waits = 0;
+};
+
+// Default instrumentation policy. Every hook is an empty inline function and
+// the containers inherit from the policy, so it costs neither code nor space.
+class NoStats {
+public:
+  void on_reallocate() const {}
+  void on_reserve(size_t) const {}
+  void on_shift(size_t) const {}
+  void on_push(size_t) const {}
+  void on_pop() const {}
+  void on_full() const {}
+  void on_empty() const {}
+
+  StatsSnapshot snapshot() const { return StatsSnapshot(); }
+};
+
+// Counting policy. Each counter is only ever bumped by one thread (the owner
+// of a Deque, or the producer or the consumer side of a LockfreeQueue), so a
+// relaxed load/store pair is enough and no locked instruction is issued on
+// the hot path. Producer and consumer counters live on separate cache lines.
+//
+// full_observed/empty_observed count every poll that found the queue full or
+// empty (spins); producer_waits/consumer_waits count how many separate times
+// a side started waiting.
+class RelaxedStats {
+public:
+  RelaxedStats();
+
+  void on_reallocate() const;
+  void on_reserve(size_t bytes) const;
+  void on_shift(size_t bytes) const;
+  void on_push(size_t size) const;
+  void on_pop() const;
+  void on_full() const;
+  void on_empty() const;
+
+  StatsSnapshot snapshot() const;
+
+private:
+  struct alignas(64) ProducerCounters {
+    std::atomic<uint64_t> reallocations;
+    std::atomic<uint64_t> reserves;
+    std::atomic<uint64_t> bytes_reserved;
+    std::atomic<uint64_t> bytes_shifted;
+    std::atomic<uint64_t> high_water;
+    std::atomic<uint64_t> full_observed;
+    std::atomic<uint64_t> waits;
+    std::atomic<bool> waiting;
+  };
+
+  struct alignas(64) ConsumerCounters {
+    std::atomic<uint64_t> empty_observed;
+    std::atomic<uint64_t> waits;
+    std::atomic<bool> waiting;
+  };
+
+  mutable ProducerCounters producer_;
+  mutable ConsumerCounters consumer_;
+
+  static void bump(std::atomic<uint64_t>& counter, uint64_t amount = 1);
+};
+
+inline RelaxedStats::RelaxedStats() {
+  producer_.reallocations.store(0, std::memory_order_relaxed);
+  producer_.reserves.store(0, std::memory_order_relaxed);
+  producer_.bytes_reserved.store(0, std::memory_order_relaxed);
+  producer_.bytes_shifted.store(0, std::memory_order_relaxed);
+  producer_.high_water.store(0, std::memory_order_relaxed);
+  producer_.full_observed.store(0, std::memory_order_relaxed);
+  producer_.waits.store(0, std::memory_order_relaxed);
+  producer_.waiting.store(false, std::memory_order_relaxed);
+  consumer_.empty_observed.store(0, std::memory_order_relaxed);
+  consumer_.waits.store(0, std::memory_order_relaxed);
+  consumer_.waiting.store(false, std::memory_order_relaxed);
+}
+
+inline void RelaxedStats::on_reallocate() const {
+  bump(producer_.reallocations);
+}
+
+inline void RelaxedStats::on_reserve(size_t bytes) const {
+  bump(producer_.reserves);
+  bump(producer_.bytes_reserved, bytes);
+}
+
+inline void RelaxedStats::on_shift(size_t bytes) const {
+  bump(producer_.bytes_shifted, bytes);
+}
+
+inline void RelaxedStats::on_push(size_t size) const {
+  if (size > producer_.high_water.load(std::memory_order_relaxed)) {
+    producer_.high_water.store(size, std::memory_order_relaxed);
+  }
+  producer_.waiting.store(false, std::memory_order_relaxed);
+}
+
+inline void RelaxedStats::on_pop() const {
+  consumer_.waiting.store(false, std::memory_order_relaxed);
+}
+
+inline void RelaxedStats::on_full() const {
+  bump(producer_.full_observed);
+  if (!producer_.waiting.load(std::memory_order_relaxed)) {
+    producer_.waiting.store(true, std::memory_order_relaxed);
+    bump(producer_.waits);
+  }
+}
+
+inline void RelaxedStats::on_empty() const {
+  bump(consumer_.empty_observed);
+  if (!consumer_.waiting.load(std::memory_order_relaxed)) {
+    consumer_.waiting.store(true, std::memory_order_relaxed);
+    bump(consumer_.waits);
+  }
+}
+
+inline StatsSnapshot RelaxedStats::snapshot() const {
+  StatsSnapshot stats;
+  stats.reallocations = producer_.reallocations.load(std::memory_order_relaxed);
+  stats.reserves = producer_.reserves.load(std::memory_order_relaxed);
+  stats.bytes_reserved = producer_.bytes_reserved.load(std::memory_order_relaxed);
+  stats.bytes_shifted = producer_.bytes_shifted.load(std::memory_order_relaxed);
+  stats.high_water = producer_.high_water.load(std::memory_order_relaxed);
+  stats.full_observed = producer_.full_observed.load(std::memory_order_relaxed);
+  stats.empty_observed = consumer_.empty_observed.load(std::memory_order_relaxed);
+  stats.producer_waits = producer_.waits.load(std::memory_order_relaxed);
+  stats.consumer_waits = consumer_.waits.load(std::memory_order_relaxed);
+  return stats;
+}
+
+inline void RelaxedStats::bump(std::atomic<uint64_t>& counter, uint64_t amount) {
+  counter.store(counter.load(std::memory_order_relaxed) + amount,
+      std::memory_order_relaxed);
+}
+}
+#endif
@@ -0,0 +1,218 @@
+#ifndef _FDT_TIMING_WHEEL_H_
+#define _FDT_TIMING_WHEEL_H_
+
+#include "Deque.h"
+
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+namespace fdt {
+// Identifies a scheduled timer. A handle goes stale once its timer fires or is
+// cancelled, even if the timer's record is reused.
+struct TimerHandle {
+  uint32_t index;
+  uint32_t generation;
+};
+
+// Hierarchical timing wheel. Time is counted in ticks of whatever unit the
+// caller uses, typically milliseconds. There are four levels of 256 slots:
+// the first covers the next 256 ticks one tick per slot, each following level
+// covers 256 times the span of the one below, and the last also holds every
+// timer further out than 2^32 ticks. A timer goes to the lowest level whose
+// span reaches its deadline, and as time passes the slots of the higher
+// levels are cascaded down a level at a time, so scheduling is O(1) and each
+// timer is moved at most three times before it fires.
+//
+// Each slot is a Deque of (record, generation) pairs; the timers themselves
+// live in a table of records that is reused through a free list. Cancelling
+// only bumps the record's generation, and the entry left in the slot is
+// skipped when the slot is drained or cascaded.
+template <typename T>
+class TimingWheel {
+public:
+  explicit TimingWheel(uint64_t now = 0);
+
+  // A deadline that is not after now() fires on the next tick.
+  TimerHandle schedule(uint64_t deadline, T value);
+  bool cancel(TimerHandle handle);
+  bool pending(TimerHandle handle) const;
+
+  // Moves the wheel to `now` one tick at a time, calling expire(T&) on the
+  // timers of each tick as a batch. `expire` may schedule and cancel timers.
+  // Returns the number of timers that fired.
+  template <class Expire>
+  size_t advance(uint64_t now, Expire expire);
+
+  uint64_t now() const;
+  size_t size() const;
+  bool empty() const;
+
+  static const size_t LEVELS = 4;
+  static const size_t SLOT_BITS = 8;
+  static const size_t SLOTS = 1 << SLOT_BITS;
+
+private:
+  struct Record {
+    T value;
+    uint64_t deadline;
+    uint32_t generation;
+    bool active;
+  };
+
+  struct Entry {
+    uint32_t index;
+    uint32_t generation;
+  };
+
+  std::vector<Deque<Entry>> slots_;
+  std::vector<Record> records_;
+  std::vector<uint32_t> free_;
+  uint64_t now_;
+  size_t size_;
+
+  static const size_t SLOT_CAPACITY = 8;
+
+  void place(Entry entry, uint64_t deadline);
+  void cascade(size_t level);
+  void release(uint32_t index);
+  Deque<Entry>& slot(size_t level, size_t index);
+};
+
+template <typename T>
+TimingWheel<T>::TimingWheel(uint64_t now)
+    : slots_(LEVELS * SLOTS, Deque<Entry>(SLOT_CAPACITY)), now_(now), size_(0) {}
+
+template <typename T>
+TimerHandle TimingWheel<T>::schedule(uint64_t deadline, T value) {
+  if (deadline <= now_) {
+    deadline = now_ + 1;
+  }
+  uint32_t index;
+  if (free_.empty()) {
+    index = (uint32_t) records_.size();
+    records_.push_back(Record{std::move(value), deadline, 0, true});
+  } else {
+    index = free_.back();
+    free_.pop_back();
+    Record& record = records_[index];
+    record.value = std::move(value);
+    record.deadline = deadline;
+    record.active = true;
+  }
+  Entry entry{index, records_[index].generation};
+  place(entry, deadline);
+  size_++;
+  return TimerHandle{entry.index, entry.generation};
+}
+
+template <typename T>
+bool TimingWheel<T>::cancel(TimerHandle handle) {
+  if (!pending(handle)) {
+    return false;
+  }
+  release(handle.index);
+  return true;
+}
+
+template <typename T>
+bool TimingWheel<T>::pending(TimerHandle handle) const {
+  return handle.index < records_.size() && records_[handle.index].active
+    && records_[handle.index].generation == handle.generation;
+}
+
+template <typename T>
+template <class Expire>
+size_t TimingWheel<T>::advance(uint64_t now, Expire expire) {
+  size_t fired = 0;
+  while (now_ < now) {
+    if (size_ == 0) {
+      now_ = now;
+      break;
+    }
+    now_++;
+    for (size_t level = LEVELS - 1; level > 0; level--) {
+      if ((now_ & ((uint64_t(1) << (SLOT_BITS * level)) - 1)) == 0) {
+        cascade(level);
+      }
+    }
+    Deque<Entry>& due = slot(0, now_ & (SLOTS - 1));
+    // Timers scheduled by `expire` land in later slots, never in this one.
+    while (!due.empty()) {
+      Entry entry = due.front();
+      due.pop_front();
+      Record& record = records_[entry.index];
+      if (!record.active || record.generation != entry.generation) {
+        continue;
+      }
+      T value = std::move(record.value);
+      release(entry.index);
+      expire(value);
+      fired++;
+    }
+  }
+  return fired;
+}
+
+template <typename T>
+uint64_t TimingWheel<T>::now() const {
+  return now_;
+}
+
+template <typename T>
+size_t TimingWheel<T>::size() const {
+  return size_;
+}
+
+template <typename T>
+bool TimingWheel<T>::empty() const {
+  return size_ == 0;
+}
+
+// The deadline is not before now(); a timer due now goes to the slot that is
+// about to be drained.
+template <typename T>
+void TimingWheel<T>::place(Entry entry, uint64_t deadline) {
+  uint64_t delta = deadline - now_;
+  size_t level = 0;
+  while (level < LEVELS - 1 && delta >= uint64_t(1) << (SLOT_BITS * (level + 1))) {
+    level++;
+  }
+  if (level == LEVELS - 1 && delta >> (SLOT_BITS * LEVELS) != 0) {
+    // Parked in the top slot that is cascaded last and placed again from
+    // there with the real deadline.
+    deadline = now_ + (uint64_t(1) << (SLOT_BITS * LEVELS)) - 1;
+  }
+  slot(level, (deadline >> (SLOT_BITS * level)) & (SLOTS - 1)).push_back(entry);
+}
+
+// Moves the slot of `level` that has just come due down to the levels below.
+template <typename T>
+void TimingWheel<T>::cascade(size_t level) {
+  Deque<Entry>& due = slot(level, (now_ >> (SLOT_BITS * level)) & (SLOTS - 1));
+  while (!due.empty()) {
+    Entry entry = due.front();
+    due.pop_front();
+    const Record& record = records_[entry.index];
+    if (record.active && record.generation == entry.generation) {
+      place(entry, record.deadline);
+    }
+  }
+}
+
+template <typename T>
+void TimingWheel<T>::release(uint32_t index) {
+  Record& record = records_[index];
+  record.value = T();
+  record.generation++;
+  record.active = false;
+  free_.push_back(index);
+  size_--;
+}
+
+template <typename T>
+Deque<typename TimingWheel<T>::Entry>& TimingWheel<T>::slot(size_t level, size_t index) {
+  return slots_[level * SLOTS + index];
+}
+}
+#endif